@@ -231,6 +231,22 @@ export class DevicesController {
     return this.lightingSystemsService.testLightingSystem(deviceId);
   }
 
+  @UseGuards(JwtAuthGuard)
+  @Get(":id/jobs/:requestId")
+  async getJobReport(
+    @Param("id") deviceId: string,
+    @Param("requestId") requestId: string,
+    @Request() req
+  ) {
+    // Verify device belongs to user
+    const device = await this.devicesService.findOne(deviceId);
+    if (device.user?.id !== req.user.userId) {
+      throw new Error("Unauthorized");
+    }
+
+    return this.lightingSystemsService.getJobReport(deviceId, requestId);
+  }
+
   @UseGuards(JwtAuthGuard)
   @Get(":id/lighting/status")
   async getLightingSystemStatus(@Param("id") deviceId: string, @Request() req) {
@@ -41,6 +41,7 @@ export class UpdateStatusDto {
   systemStats?: {
     freeHeap?: number;
     uptime?: number;
+    paletteLatency?: any; // Per-stage palette latency percentiles from the device
     lastUpdate?: Date;
   };
 }
@@ -13,7 +13,10 @@ import {
   UpdateLightingSystemDto,
   LightingSystemStatusDto,
 } from "./dto/lighting-system/lighting-system.dto";
-import { DeviceWebSocketService } from "../messages/device-websocket.service";
+import {
+  DeviceWebSocketService,
+  JobReport,
+} from "../messages/device-websocket.service";
 
 @Injectable()
 export class LightingSystemsService {
@@ -30,7 +33,7 @@ export class LightingSystemsService {
   async configureLightingSystem(
     deviceId: string,
     config: LightingSystemConfigDto
-  ): Promise<Device> {
+  ): Promise<Device & { requestId: string | null }> {
     const device = await this.deviceRepository.findOne({
       where: { id: deviceId },
       relations: ["user"],
@@ -54,12 +57,13 @@ export class LightingSystemsService {
 
     const savedDevice = await this.deviceRepository.save(device);
 
-    // Send configuration to device via WebSocket if connected
-    const configSent = this.webSocketService.sendLightingSystemConfig(
+    // Send configuration to device via WebSocket if connected; the device
+    // reports the result under requestId (see getJobReport)
+    const requestId = this.webSocketService.sendLightingSystemConfig(
       deviceId,
       savedDevice
     );
-    if (configSent) {
+    if (requestId) {
       console.log(`🌈 Lighting configuration sent to device ${deviceId}`);
     } else {
       console.log(
@@ -67,7 +71,7 @@ export class LightingSystemsService {
       );
     }
 
-    return savedDevice;
+    return { ...savedDevice, requestId };
   }
 
   /**
@@ -229,9 +233,11 @@ export class LightingSystemsService {
   /**
    * Test lighting system connection
    */
-  async testLightingSystem(
-    deviceId: string
-  ): Promise<{ testRequested: boolean; deviceConnected: boolean }> {
+  async testLightingSystem(deviceId: string): Promise<{
+    testRequested: boolean;
+    deviceConnected: boolean;
+    requestId: string | null;
+  }> {
     const device = await this.deviceRepository.findOne({
       where: { id: deviceId },
       relations: ["user"],
@@ -242,8 +248,8 @@ export class LightingSystemsService {
     }
 
     // Request lighting system test via WebSocket
-    const deviceConnected =
-      this.webSocketService.requestLightingSystemTest(deviceId);
+    const requestId = this.webSocketService.requestLightingSystemTest(deviceId);
+    const deviceConnected = requestId !== null;
 
     if (deviceConnected) {
       // Update test timestamp
@@ -257,9 +263,21 @@ export class LightingSystemsService {
     return {
       testRequested: true,
       deviceConnected: deviceConnected,
+      requestId,
     };
   }
 
+  /**
+   * Progress and result of a lighting command sent to the device
+   */
+  getJobReport(deviceId: string, requestId: string): JobReport {
+    const report = this.webSocketService.getJobReport(requestId);
+    if (!report || report.deviceId !== deviceId) {
+      throw new NotFoundException("Job not found");
+    }
+    return report;
+  }
+
   /**
    * Check if a lighting system requires authentication
    */
@@ -0,0 +1,311 @@
+import { NotFoundException } from "@nestjs/common";
+import * as WebSocket from "ws";
+import {
+  DeviceWebSocketService,
+  SESSION_TTL_MS,
+} from "./device-websocket.service";
+import { decodePaletteFrame, PALETTE_FRAME_FORMAT } from "./palette-frame";
+
+// Minimal stand-in for a device connection
+class FakeDeviceSocket {
+  readyState = WebSocket.OPEN;
+  sent: { data: any; options?: any }[] = [];
+
+  send(data: any, options?: any) {
+    this.sent.push({ data, options });
+  }
+
+  lastJson() {
+    return JSON.parse(this.sent[this.sent.length - 1].data);
+  }
+}
+
+describe("DeviceWebSocketService palette delivery", () => {
+  const deviceId = "8d3c7a52-1f4e-4b6a-9c2d-0e1f2a3b4c5d";
+  const palette = {
+    messageId: "3f2b8c1e-5a6d-4e7f-9a0b-1c2d3e4f5a6b",
+    senderId: "sender-id",
+    senderName: "Alice",
+    colors: [{ hex: "#ff0000" }, { hex: "#00ff00" }],
+    timestamp: 1735787045678,
+  };
+
+  let service: DeviceWebSocketService;
+  let socket: FakeDeviceSocket;
+  let devicesService: { findOne: jest.Mock };
+  let devicePairingService: { generateNewPairingCode: jest.Mock };
+
+  const register = async (data: any) => {
+    await (service as any).handleMessage(socket, {
+      event: "registerDevice",
+      data: { deviceId, ...data },
+    });
+  };
+
+  beforeEach(() => {
+    devicesService = { findOne: jest.fn().mockResolvedValue({ id: deviceId }) };
+    devicePairingService = {
+      generateNewPairingCode: jest.fn().mockResolvedValue("K7M2QX"),
+    };
+    service = new DeviceWebSocketService(
+      devicesService as any,
+      devicePairingService as any
+    );
+    socket = new FakeDeviceSocket();
+  });
+
+  afterEach(() => {
+    jest.restoreAllMocks();
+  });
+
+  it("sends JSON palettes to devices that do not offer binary frames", async () => {
+    await register({});
+
+    expect(socket.lastJson().data.paletteFormat).toBe("json");
+
+    expect(service.sendColorPaletteToDevice(deviceId, palette)).toBe(true);
+    expect(socket.lastJson()).toMatchObject({
+      event: "colorPalette",
+      messageId: palette.messageId,
+      colors: palette.colors,
+      timestamp: palette.timestamp,
+    });
+    expect(socket.lastJson().sentAt).toBeGreaterThanOrEqual(palette.timestamp);
+  });
+
+  it("negotiates binary frames and sends palettes as binary", async () => {
+    await register({ paletteFormats: [PALETTE_FRAME_FORMAT, "json"] });
+
+    expect(socket.lastJson().data.paletteFormat).toBe(PALETTE_FRAME_FORMAT);
+
+    expect(service.sendColorPaletteToDevice(deviceId, palette)).toBe(true);
+
+    const last = socket.sent[socket.sent.length - 1];
+    expect(last.options).toEqual({ binary: true });
+    expect(decodePaletteFrame(last.data)).toEqual({
+      messageId: palette.messageId,
+      senderName: "Alice",
+      timestamp: palette.timestamp,
+      sentAt: expect.any(Number),
+      colors: palette.colors,
+    });
+  });
+
+  it("falls back to JSON when a palette does not fit a binary frame", async () => {
+    await register({ paletteFormats: [PALETTE_FRAME_FORMAT, "json"] });
+
+    const colors = Array.from({ length: 12 }, () => ({ hex: "#000000" }));
+    expect(
+      service.sendColorPaletteToDevice(deviceId, { ...palette, colors })
+    ).toBe(true);
+    expect(socket.lastJson().event).toBe("colorPalette");
+  });
+
+  it("asks unknown devices to register over HTTP", async () => {
+    devicesService.findOne.mockRejectedValue(
+      new NotFoundException("Device not found")
+    );
+
+    await register({});
+
+    expect(socket.lastJson()).toEqual({
+      event: "registrationError",
+      data: { error: "Unknown device. Register over HTTP first." },
+    });
+  });
+
+  it("tells registering devices whether they are claimed", async () => {
+    devicesService.findOne.mockResolvedValue({
+      id: deviceId,
+      user: { id: "user-id" },
+    });
+    await register({});
+    expect(socket.lastJson().data).toMatchObject({
+      claimed: true,
+      pairingCode: null,
+    });
+
+    devicesService.findOne.mockResolvedValue({
+      id: deviceId,
+      pairingCode: "OLD234",
+      pairingCodeExpiresAt: new Date(Date.now() - 1000),
+    });
+    await register({});
+    expect(socket.lastJson().data).toMatchObject({
+      claimed: false,
+      pairingCode: "K7M2QX",
+    });
+    expect(devicePairingService.generateNewPairingCode).toHaveBeenCalledWith(
+      deviceId
+    );
+  });
+
+  it("answers timeSync with the device's t0 and the server clock", async () => {
+    const before = Date.now();
+    await (service as any).handleMessage(socket, {
+      event: "timeSync",
+      data: { deviceId, t0: 12345 },
+    });
+
+    const reply = socket.lastJson();
+    expect(reply.event).toBe("timeSync");
+    expect(reply.data.t0).toBe(12345);
+    expect(reply.data.serverTime).toBeGreaterThanOrEqual(before);
+  });
+
+  describe("job reports", () => {
+    let requestId: string;
+
+    const report = (event: string, data: any) =>
+      (service as any).handleMessage(socket, {
+        event,
+        data: {
+          deviceId,
+          jobId: 3,
+          type: "lightingConfig",
+          requestId,
+          ...data,
+        },
+      });
+
+    beforeEach(async () => {
+      await register({});
+      requestId = service.sendLightingSystemConfig(deviceId, {
+        lightingSystemType: "wled",
+        lightingHostAddress: "192.168.1.50",
+        lightingPort: 80,
+      });
+    });
+
+    it("returns the requestId the device echoes", () => {
+      expect(requestId).toEqual(expect.any(String));
+      expect(socket.lastJson().data.requestId).toBe(requestId);
+      expect(service.getJobReport(requestId)).toMatchObject({
+        deviceId,
+        status: "pending",
+        progress: [],
+      });
+    });
+
+    it("keeps the first report and the result while capping progress", async () => {
+      await report("jobProgress", { stage: "queued", progress: 0 });
+      for (let i = 1; i <= 50; i++) {
+        await report("jobProgress", { stage: "authenticating", progress: i });
+      }
+      await report("jobCompleted", { success: true, durationMs: 1200 });
+      await report("jobProgress", { stage: "late", progress: 99 });
+
+      const job = service.getJobReport(requestId);
+      expect(job.status).toBe("completed");
+      expect(job.first).toMatchObject({ event: "jobProgress", stage: "queued" });
+      expect(job.result).toMatchObject({ event: "jobCompleted", success: true });
+      expect(job.progress.length).toBeLessThan(50);
+      expect(job.progress[job.progress.length - 1].progress).toBe(50);
+    });
+
+    it("ignores reports for requests it did not send", async () => {
+      requestId = "unknown";
+      await report("jobCompleted", { success: false, error: "boom" });
+      expect(service.getJobReport("unknown")).toBeUndefined();
+    });
+
+    it("returns null when the device is not connected", () => {
+      expect(
+        service.requestLightingSystemTest("00000000-0000-0000-0000-000000000000")
+      ).toBeNull();
+    });
+  });
+
+  describe("session resume", () => {
+    const resume = async (ws: FakeDeviceSocket, sessionToken: string) => {
+      await (service as any).handleMessage(ws, {
+        event: "resumeSession",
+        data: { deviceId, sessionToken },
+      });
+    };
+
+    it("resumes with the registration token and replays a missed palette", async () => {
+      await register({ paletteFormats: ["json"] });
+      const { sessionToken } = socket.lastJson().data;
+      expect(sessionToken).toEqual(expect.any(String));
+
+      (service as any).removeDeviceConnection(socket);
+      expect(service.sendColorPaletteToDevice(deviceId, palette)).toBe(false);
+
+      const reconnected = new FakeDeviceSocket();
+      await resume(reconnected, sessionToken);
+
+      expect(JSON.parse(reconnected.sent[0].data)).toEqual({
+        event: "sessionResumed",
+        data: { deviceId, paletteFormat: "json", replay: true },
+      });
+      expect(reconnected.lastJson()).toMatchObject({
+        event: "colorPalette",
+        messageId: palette.messageId,
+      });
+    });
+
+    it("rejects unknown or expired tokens", async () => {
+      await register({});
+      const { sessionToken } = socket.lastJson().data;
+
+      await resume(socket, "not-the-token");
+      expect(socket.lastJson().event).toBe("sessionRejected");
+
+      (service as any).removeDeviceConnection(socket);
+      const now = Date.now();
+      jest.spyOn(Date, "now").mockReturnValue(now + SESSION_TTL_MS + 1);
+
+      await resume(socket, sessionToken);
+      expect(socket.lastJson().event).toBe("sessionRejected");
+    });
+  });
+
+  describe("status reports", () => {
+    let handleDeviceStatus: jest.SpyInstance;
+
+    beforeEach(() => {
+      handleDeviceStatus = jest
+        .spyOn(service as any, "handleDeviceStatus")
+        .mockResolvedValue(undefined);
+    });
+
+    const report = (data: any) =>
+      (service as any).handleMessage(socket, {
+        event: "deviceStatus",
+        data: { deviceId, ...data },
+      });
+
+    it("merges deltas into the last full snapshot", async () => {
+      await report({ firmwareVersion: "2.0.0", freeHeap: 1000, uptime: 10 });
+      await report({ delta: true, freeHeap: 900, uptime: 40 });
+
+      expect(handleDeviceStatus).toHaveBeenLastCalledWith(socket, {
+        deviceId,
+        firmwareVersion: "2.0.0",
+        freeHeap: 900,
+        uptime: 40,
+      });
+    });
+
+    it("handles batched frames in order", async () => {
+      await (service as any).handleFrame(socket, [
+        { event: "registerDevice", data: { deviceId } },
+        { event: "deviceStatus", data: { deviceId, uptime: 10 } },
+      ]);
+
+      expect(JSON.parse(socket.sent[0].data).event).toBe("deviceRegistered");
+      expect(handleDeviceStatus).toHaveBeenCalledWith(socket, {
+        deviceId,
+        uptime: 10,
+      });
+    });
+
+    it("requests a full snapshot when a delta arrives first", async () => {
+      await report({ delta: true, uptime: 40 });
+
+      expect(handleDeviceStatus).not.toHaveBeenCalled();
+      expect(socket.lastJson()).toEqual({ event: "requestStatus" });
+    });
+  });
+});
@@ -4,21 +4,63 @@ import {
   OnApplicationBootstrap,
   Inject,
   forwardRef,
+  NotFoundException,
 } from "@nestjs/common";
 import * as WebSocket from "ws";
 import { createServer } from "http";
+import { randomBytes, timingSafeEqual } from "crypto";
 import { DevicesService } from "../devices/devices.service";
+import { DevicePairingService } from "../devices/services/device-pairing.service";
+import { Device } from "../devices/entities/device.entity";
+import {
+  encodePaletteFrame,
+  paletteTimestamp,
+  PALETTE_FRAME_FORMAT,
+} from "./palette-frame";
+
+// Resumable device session, issued on registration. A device that reconnects
+// within SESSION_TTL_MS presents the token instead of registering again.
+interface DeviceSession {
+  token: string;
+  paletteFormat: string;
+  disconnectedAt?: number;
+  missedPalette?: any; // Latest palette sent while the device was offline
+}
+
+export const SESSION_TTL_MS = 10 * 60 * 1000;
+
+// Job reports kept per request, and progress reports kept per job. The
+// first report and the result of a job are never evicted.
+const MAX_JOB_REPORTS = 200;
+const MAX_JOB_PROGRESS_REPORTS = 20;
+
+export interface JobReport {
+  requestId: string;
+  deviceId: string; // Database UUID of the device the command was sent to
+  status: "pending" | "running" | "completed" | "failed";
+  first?: any; // Usually the "queued" stage
+  progress: any[]; // Latest jobProgress reports after the first
+  result?: any; // jobCompleted
+}
 
 @Injectable()
 export class DeviceWebSocketService implements OnApplicationBootstrap {
   private readonly logger = new Logger(DeviceWebSocketService.name);
   private wss: WebSocket.Server;
   private deviceConnections = new Map<string, WebSocket>(); // Database UUID -> WebSocket
+  private paletteFormats = new Map<string, string>(); // Database UUID -> negotiated palette format
+  // Last full status per device; devices send only changed fields ("delta")
+  private deviceStatusSnapshots = new Map<string, any>();
+  private lightingStatusSnapshots = new Map<string, any>();
+  private sessions = new Map<string, DeviceSession>(); // Database UUID -> session
+  private jobReports = new Map<string, JobReport>(); // requestId -> job report
   private server: any;
 
   constructor(
     @Inject(forwardRef(() => DevicesService))
-    private readonly devicesService: DevicesService
+    private readonly devicesService: DevicesService,
+    @Inject(forwardRef(() => DevicePairingService))
+    private readonly devicePairingService: DevicePairingService
   ) {}
 
   async onApplicationBootstrap() {
@@ -77,13 +119,15 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
         });
 
         ws.on("message", (data: WebSocket.Data) => {
+          let message: any;
           try {
-            const message = JSON.parse(data.toString());
-            this.handleMessage(ws, message);
+            message = JSON.parse(data.toString());
           } catch (error) {
             this.logger.error(`JSON parse error: ${error.message}`);
             ws.send(JSON.stringify({ error: "Invalid JSON" }));
+            return;
           }
+          this.handleFrame(ws, message);
         });
 
         ws.on("close", () => {
@@ -124,11 +168,29 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
     }
   }
 
+  /**
+   * Devices coalesce the messages of one loop pass into a single frame as a
+   * JSON array. Messages are handled in order, so registration completes
+   * before the status reports sent with it.
+   */
+  private async handleFrame(ws: WebSocket, frame: any) {
+    const messages = Array.isArray(frame) ? frame : [frame];
+    for (const message of messages) {
+      try {
+        await this.handleMessage(ws, message);
+      } catch (error) {
+        this.logger.error(
+          `Error handling ${message?.event ?? "unknown"} message: ${error.message}`
+        );
+      }
+    }
+  }
+
   private async handleMessage(ws: WebSocket, message: any) {
     this.logger.log("Received message:", message);
 
     if (message.event === "registerDevice") {
-      const { deviceId } = message.data;
+      const { deviceId, paletteFormats } = message.data;
 
       this.logger.log(`🔍 Device registration request for: ${deviceId}`);
 
@@ -148,6 +210,24 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
         return;
       }
 
+      // Devices skip the HTTP registration when nothing changed since the
+      // last one, so make sure the backend still knows them
+      const device = await this.findKnownDevice(deviceId);
+      if (device === null) {
+        this.logger.warn(
+          `❌ Unknown device ${deviceId}, asking it to register over HTTP`
+        );
+        ws.send(
+          JSON.stringify({
+            event: "registrationError",
+            data: {
+              error: "Unknown device. Register over HTTP first.",
+            },
+          })
+        );
+        return;
+      }
+
       // Check if device was previously connected
       if (this.deviceConnections.has(deviceId)) {
         this.logger.log(`Device was already registered, updating connection`);
@@ -155,6 +235,15 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
 
       // Register WebSocket connection with database UUID
       this.deviceConnections.set(deviceId, ws);
+
+      // Binary palette frames only for devices that offer them; JSON otherwise
+      const paletteFormat =
+        Array.isArray(paletteFormats) &&
+        paletteFormats.includes(PALETTE_FRAME_FORMAT)
+          ? PALETTE_FRAME_FORMAT
+          : "json";
+      this.paletteFormats.set(deviceId, paletteFormat);
+      const session = this.openSession(deviceId, paletteFormat);
       this.logger.log(
         `✅ Device registered: ${deviceId} (Total connected: ${this.deviceConnections.size})`
       );
@@ -165,17 +254,47 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
       ws.send(
         JSON.stringify({
           event: "deviceRegistered",
-          data: { deviceId: deviceId, status: "registered" },
+          data: {
+            deviceId: deviceId,
+            status: "registered",
+            paletteFormat,
+            sessionToken: session.token,
+            sessionTtl: SESSION_TTL_MS,
+            ...(device ? await this.getClaimStatus(device) : {}),
+          },
         })
       );
+    } else if (message.event === "resumeSession") {
+      this.handleResumeSession(ws, message.data);
     } else if (message.event === "completeSetup") {
       this.handleSetupCompletion(ws, message.data);
     } else if (message.event === "lightingSystemStatus") {
-      this.handleLightingSystemStatus(ws, message.data);
+      const status = this.mergeStatusReport(
+        ws,
+        this.lightingStatusSnapshots,
+        message.data
+      );
+      if (status) {
+        this.handleLightingSystemStatus(ws, status);
+      }
     } else if (message.event === "deviceStatus") {
-      this.handleDeviceStatus(ws, message.data);
+      const status = this.mergeStatusReport(
+        ws,
+        this.deviceStatusSnapshots,
+        message.data
+      );
+      if (status) {
+        this.handleDeviceStatus(ws, status);
+      }
     } else if (message.event === "lightingSystemTest") {
       this.handleLightingSystemTest(ws, message.data);
+    } else if (message.event === "timeSync") {
+      this.handleTimeSync(ws, message.data);
+    } else if (
+      message.event === "jobProgress" ||
+      message.event === "jobCompleted"
+    ) {
+      this.handleJobReport(message.event, message.data);
     } else if (message.event === "userActionRequired") {
       this.handleUserActionRequired(ws, message.data);
     } else if (message.event === "user_action_required") {
@@ -186,6 +305,248 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
     }
   }
 
+  /**
+   * Null only when the database has no such device. A failed lookup returns
+   * undefined and lets the registration through rather than locking devices
+   * out.
+   */
+  private async findKnownDevice(
+    deviceId: string
+  ): Promise<Device | null | undefined> {
+    try {
+      return await this.devicesService.findOne(deviceId);
+    } catch (error) {
+      return error instanceof NotFoundException ? null : undefined;
+    }
+  }
+
+  /**
+   * Claim status for the deviceRegistered reply. Devices that skipped the
+   * HTTP registration learn here whether they were claimed or released
+   * while offline. An expired pairing code is replaced, as the HTTP
+   * registration would have done.
+   */
+  private async getClaimStatus(
+    device: Device
+  ): Promise<{ claimed: boolean; pairingCode: string | null }> {
+    if (device.user) {
+      return { claimed: true, pairingCode: null };
+    }
+
+    let pairingCode = device.pairingCode || null;
+    if (
+      !pairingCode ||
+      (device.pairingCodeExpiresAt && device.pairingCodeExpiresAt < new Date())
+    ) {
+      try {
+        pairingCode = await this.devicePairingService.generateNewPairingCode(
+          device.id
+        );
+      } catch (error) {
+        this.logger.warn(
+          `Could not refresh pairing code for ${device.id}: ${error.message}`
+        );
+      }
+    }
+    return { claimed: false, pairingCode };
+  }
+
+  /**
+   * Long-running device commands (lighting configuration, authentication,
+   * tests, factory reset) report progress while they run and a final result.
+   * Commands sent by the backend carry a requestId that the reports echo.
+   */
+  private handleJobReport(event: string, data: any) {
+    const { deviceId, jobId, requestId, type } = data || {};
+
+    if (event === "jobCompleted") {
+      const outcome = data.success ? "completed" : `failed: ${data.error}`;
+      this.logger.log(
+        `Job ${jobId} (${type}) on ${deviceId} ${outcome} after ${data.durationMs} ms`
+      );
+    } else {
+      this.logger.debug(
+        `Job ${jobId} (${type}) on ${deviceId}: ${data.stage} ${data.progress}%`
+      );
+    }
+
+    if (requestId) {
+      this.recordJobReport(requestId, { ...data, event });
+    }
+  }
+
+  private createJobReport(requestId: string, deviceId: string): JobReport {
+    if (this.jobReports.size >= MAX_JOB_REPORTS) {
+      this.jobReports.delete(this.jobReports.keys().next().value);
+    }
+    const report: JobReport = {
+      requestId,
+      deviceId,
+      status: "pending",
+      progress: [],
+    };
+    this.jobReports.set(requestId, report);
+    return report;
+  }
+
+  private recordJobReport(requestId: string, entry: any) {
+    // Requests this backend did not send, or has already evicted, have no reader
+    const report = this.jobReports.get(requestId);
+    if (!report) {
+      return;
+    }
+
+    if (!report.first) {
+      report.first = entry;
+      report.status = "running";
+    } else if (report.result) {
+      // A late progress report must not hide the result
+      return;
+    } else if (entry.event === "jobProgress") {
+      report.progress.push(entry);
+      if (report.progress.length > MAX_JOB_PROGRESS_REPORTS) {
+        report.progress.shift();
+      }
+    }
+
+    if (entry.event === "jobCompleted") {
+      report.result = entry;
+      report.status = entry.success ? "completed" : "failed";
+    }
+  }
+
+  /**
+   * Reports for a command sent with the given requestId: the first one,
+   * the latest progress and the result once the job has finished
+   */
+  getJobReport(requestId: string): JobReport | undefined {
+    return this.jobReports.get(requestId);
+  }
+
+  private openSession(deviceId: string, paletteFormat: string): DeviceSession {
+    this.pruneExpiredSessions();
+
+    // A full registration starts over, so earlier status snapshots are stale
+    this.deviceStatusSnapshots.delete(deviceId);
+    this.lightingStatusSnapshots.delete(deviceId);
+
+    const session: DeviceSession = {
+      token: randomBytes(16).toString("hex"),
+      paletteFormat,
+    };
+    this.sessions.set(deviceId, session);
+    return session;
+  }
+
+  private isSessionExpired(session: DeviceSession): boolean {
+    return (
+      session.disconnectedAt !== undefined &&
+      Date.now() - session.disconnectedAt > SESSION_TTL_MS
+    );
+  }
+
+  private pruneExpiredSessions() {
+    for (const [deviceId, session] of this.sessions.entries()) {
+      if (this.isSessionExpired(session)) {
+        this.sessions.delete(deviceId);
+        this.deviceStatusSnapshots.delete(deviceId);
+        this.lightingStatusSnapshots.delete(deviceId);
+      }
+    }
+  }
+
+  /**
+   * Reconnect without a full registration: restore the connection with the
+   * negotiated palette format and replay the latest palette the device
+   * missed while it was offline.
+   */
+  private handleResumeSession(ws: WebSocket, data: any) {
+    const { deviceId, sessionToken } = data || {};
+    const session = deviceId ? this.sessions.get(deviceId) : undefined;
+
+    const valid =
+      session !== undefined &&
+      typeof sessionToken === "string" &&
+      sessionToken.length === session.token.length &&
+      timingSafeEqual(Buffer.from(sessionToken), Buffer.from(session.token)) &&
+      !this.isSessionExpired(session);
+
+    if (!valid) {
+      this.logger.log(
+        `Session resume rejected for ${deviceId}, device must register`
+      );
+      ws.send(JSON.stringify({ event: "sessionRejected", data: { deviceId } }));
+      return;
+    }
+
+    this.deviceConnections.set(deviceId, ws);
+    this.paletteFormats.set(deviceId, session.paletteFormat);
+    session.disconnectedAt = undefined;
+
+    const missedPalette = session.missedPalette;
+    session.missedPalette = undefined;
+
+    ws.send(
+      JSON.stringify({
+        event: "sessionResumed",
+        data: {
+          deviceId,
+          paletteFormat: session.paletteFormat,
+          replay: missedPalette !== undefined,
+        },
+      })
+    );
+    this.logger.log(
+      `⚡ Session resumed: ${deviceId} (Total connected: ${this.deviceConnections.size})`
+    );
+
+    if (missedPalette !== undefined) {
+      this.sendColorPaletteToDevice(deviceId, missedPalette);
+    }
+  }
+
+  /**
+   * Devices report only the fields that changed since their last report,
+   * marked with delta: true. Merge them into the last known snapshot so the
+   * handlers always see a complete status. A delta without a snapshot (e.g.
+   * after a backend restart) asks the device for a full report instead.
+   */
+  private mergeStatusReport(
+    ws: WebSocket,
+    snapshots: Map<string, any>,
+    data: any
+  ): any | null {
+    const { deviceId, delta, ...fields } = data || {};
+    if (!deviceId) {
+      return data;
+    }
+
+    const previous = snapshots.get(deviceId);
+    if (delta && !previous) {
+      this.logger.debug(
+        `Status delta from ${deviceId} without a snapshot, requesting full status`
+      );
+      ws.send(JSON.stringify({ event: "requestStatus" }));
+      return null;
+    }
+
+    const merged = delta
+      ? { ...previous, ...fields, deviceId }
+      : { ...fields, deviceId };
+    snapshots.set(deviceId, merged);
+    return merged;
+  }
+
+  private handleTimeSync(ws: WebSocket, data: any) {
+    // Echo the device's send time with ours so it can estimate the offset
+    ws.send(
+      JSON.stringify({
+        event: "timeSync",
+        data: { t0: data?.t0, serverTime: Date.now() },
+      })
+    );
+  }
+
   private async sendPendingLightingConfig(deviceId: string): Promise<void> {
     // This method would check if there's pending lighting configuration
     // for the device and send it if needed
@@ -354,8 +715,17 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
         wifiRSSI,
         freeHeap,
         uptime,
+        paletteLatency,
+        boot,
+        loop,
       } = data;
 
+      if (boot?.complete) {
+        this.logger.log(
+          `⏱ ${deviceId} (firmware ${firmwareVersion}) operational ${boot.timeToOperationalMs} ms after boot`
+        );
+      }
+
       // Update device status via HTTP API
       const updateData = {
         isOnline: isOnline !== undefined ? isOnline : true,
@@ -367,6 +737,9 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
         systemStats: {
           freeHeap,
           uptime,
+          paletteLatency,
+          boot,
+          loop,
           lastUpdate: new Date(),
         },
       };
@@ -568,9 +941,15 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
       }
     }
 
-    // Remove all found connections
+    // Remove all found connections. Sessions and status snapshots are kept
+    // so the device can resume within SESSION_TTL_MS.
     for (const deviceId of devicesToRemove) {
       this.deviceConnections.delete(deviceId);
+      this.paletteFormats.delete(deviceId);
+      const session = this.sessions.get(deviceId);
+      if (session) {
+        session.disconnectedAt = Date.now();
+      }
       this.logger.log(`🗑️ Removed device connection: ${deviceId}`);
     }
 
@@ -595,13 +974,30 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
     const ws = this.deviceConnections.get(deviceId);
 
     if (ws && ws.readyState === WebSocket.OPEN) {
+      const sentAt = Date.now();
+
+      if (this.paletteFormats.get(deviceId) === PALETTE_FRAME_FORMAT) {
+        const frame = encodePaletteFrame(palette, sentAt);
+        if (frame) {
+          ws.send(frame, { binary: true });
+          this.logger.log(
+            `Color palette sent to device: ${deviceId} (${frame.length} byte binary frame)`
+          );
+          return true;
+        }
+        this.logger.debug(
+          `Palette for ${deviceId} does not fit a binary frame, sending JSON`
+        );
+      }
+
       const message = {
         event: "colorPalette",
         messageId: palette.messageId,
         senderId: palette.senderId,
         senderName: palette.senderName,
         colors: palette.colors,
-        timestamp: palette.timestamp || Date.now(),
+        timestamp: paletteTimestamp(palette.timestamp),
+        sentAt,
       };
 
       ws.send(JSON.stringify(message));
@@ -618,6 +1014,13 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
     }
 
     this.logger.warn(`Device ${deviceId} not connected`);
+
+    // Replayed when the device resumes its session
+    const session = this.sessions.get(deviceId);
+    if (session && !this.isSessionExpired(session)) {
+      session.missedPalette = palette;
+      this.logger.log(`Palette for ${deviceId} held for session resume`);
+    }
     return false;
   }
 
@@ -671,7 +1074,11 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
     return connectedDevices;
   }
 
-  sendLightingSystemConfig(deviceId: string, config: any): boolean {
+  /**
+   * @returns the requestId echoed by the device's job reports, or null when
+   * the device is not connected
+   */
+  sendLightingSystemConfig(deviceId: string, config: any): string | null {
     const ws = this.deviceConnections.get(deviceId);
 
     if (ws && ws.readyState === WebSocket.OPEN) {
@@ -708,6 +1115,10 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
         messageData.customConfig = config.lightingCustomConfig;
       }
 
+      // Echoed in the device's jobProgress/jobCompleted reports
+      messageData.requestId = randomBytes(8).toString("hex");
+      this.createJobReport(messageData.requestId, deviceId);
+
       const message = {
         event: "lightingSystemConfig",
         data: messageData,
@@ -716,14 +1127,18 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
       ws.send(JSON.stringify(message));
       this.logger.log(`Lighting system config sent to device: ${deviceId}`);
       this.logger.debug(`Config data: ${JSON.stringify(messageData)}`);
-      return true;
+      return messageData.requestId;
     }
 
     this.logger.warn(`Device ${deviceId} not connected for lighting config`);
-    return false;
+    return null;
   }
 
-  requestLightingSystemTest(deviceId: string): boolean {
+  /**
+   * @returns the requestId echoed by the device's job reports, or null when
+   * the device is not connected
+   */
+  requestLightingSystemTest(deviceId: string): string | null {
     this.logger.debug(
       `Attempting to send lighting test to device: ${deviceId}`
     );
@@ -736,17 +1151,20 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
     const ws = this.deviceConnections.get(deviceId);
 
     if (ws && ws.readyState === WebSocket.OPEN) {
+      const requestId = randomBytes(8).toString("hex");
       const message = {
         event: "testLightingSystem",
         data: {
           deviceId: deviceId,
           timestamp: Date.now(),
+          requestId,
         },
       };
 
       ws.send(JSON.stringify(message));
+      this.createJobReport(requestId, deviceId);
       this.logger.log(`Lighting system test requested for device: ${deviceId}`);
-      return true;
+      return requestId;
     }
 
     if (ws) {
@@ -758,7 +1176,7 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
     }
 
     this.logger.warn(`Device ${deviceId} not connected for lighting test`);
-    return false;
+    return null;
   }
 
   sendFactoryReset(deviceId: string): boolean {
@@ -786,8 +1204,10 @@ export class DeviceWebSocketService implements OnApplicationBootstrap {
       ws.send(JSON.stringify(message));
       this.logger.log(`Factory reset command sent to device: ${deviceId}`);
 
-      // Remove the device from our connections since it will restart
-      this.removeDeviceConnection(deviceId);
+      // Remove the device from our connections since it will restart, and
+      // forget its session: it registers from scratch after the reset
+      this.removeDeviceConnection(ws);
+      this.sessions.delete(deviceId);
 
       return true;
     }
@@ -0,0 +1,73 @@
+import {
+  decodePaletteFrame,
+  encodePaletteFrame,
+  PALETTE_FRAME_MAGIC,
+} from "./palette-frame";
+
+describe("palette-frame", () => {
+  const palette = {
+    messageId: "3f2b8c1e-5a6d-4e7f-9a0b-1c2d3e4f5a6b",
+    senderId: "sender-id",
+    senderName: "Alice",
+    colors: [{ hex: "#FF0000" }, { hex: "#00ff80" }, { hex: "#123456" }],
+    timestamp: new Date("2025-01-02T03:04:05.678Z"),
+  };
+
+  it("encodes a UUID palette into a compact frame", () => {
+    const frame = encodePaletteFrame(palette);
+
+    // header + packed UUID + name + 3 RGB triplets
+    expect(frame).not.toBeNull();
+    expect(frame!.length).toBe(12 + 16 + 1 + 5 + 9);
+    expect(frame![0]).toBe(PALETTE_FRAME_MAGIC);
+    expect(frame!.length).toBeLessThan(
+      Buffer.byteLength(JSON.stringify({ event: "colorPalette", ...palette }))
+    );
+  });
+
+  it("round-trips ids, sender, timestamp and colors", () => {
+    const decoded = decodePaletteFrame(encodePaletteFrame(palette)!);
+
+    expect(decoded).toEqual({
+      messageId: palette.messageId,
+      senderName: "Alice",
+      timestamp: palette.timestamp.getTime(),
+      colors: [{ hex: "#ff0000" }, { hex: "#00ff80" }, { hex: "#123456" }],
+    });
+  });
+
+  it("carries the send time when one is given", () => {
+    const sentAt = palette.timestamp.getTime() + 25;
+    const frame = encodePaletteFrame(palette, sentAt)!;
+
+    expect(frame.length).toBe(12 + 8 + 16 + 1 + 5 + 9);
+    expect(decodePaletteFrame(frame)!.sentAt).toBe(sentAt);
+  });
+
+  it("keeps non-UUID message ids as text", () => {
+    const decoded = decodePaletteFrame(
+      encodePaletteFrame({ ...palette, messageId: "msg-42" })!
+    );
+
+    expect(decoded!.messageId).toBe("msg-42");
+  });
+
+  it("falls back to JSON for palettes the device cannot hold", () => {
+    const colors = Array.from({ length: 11 }, () => ({ hex: "#000000" }));
+
+    expect(encodePaletteFrame({ ...palette, colors })).toBeNull();
+    expect(
+      encodePaletteFrame({ ...palette, colors: [{ hex: "red" }] })
+    ).toBeNull();
+    expect(
+      encodePaletteFrame({ ...palette, senderName: "x".repeat(41) })
+    ).toBeNull();
+  });
+
+  it("rejects truncated frames", () => {
+    const frame = encodePaletteFrame(palette)!;
+
+    expect(decodePaletteFrame(frame.subarray(0, frame.length - 1))).toBeNull();
+    expect(decodePaletteFrame(Buffer.from([0x7b, 0x22]))).toBeNull();
+  });
+});
@@ -0,0 +1,224 @@
+/**
+ * Binary colorPalette frames for ESP32 devices.
+ *
+ * Devices that advertise PALETTE_FRAME_FORMAT in registerDevice receive
+ * palettes as a fixed-layout binary WebSocket frame instead of JSON:
+ *
+ *   offset  size  field
+ *   0       1     magic 0x50 ("P")
+ *   1       1     frame type (0x01 = colorPalette)
+ *   2       1     flags (bit 0: messageId packed as a 16-byte UUID,
+ *                        bit 1: send time follows the header)
+ *   3       1     color count
+ *   4       8     timestamp, ms since epoch (uint64, little-endian)
+ *   [12     8     send time, ms since epoch, when flag bit 1 is set]
+ *   ...     ...   messageId: 16 UUID bytes, or 1 length byte + UTF-8
+ *   ...     ...   senderName: 1 length byte + UTF-8
+ *   ...     3*n   colors as packed RGB triplets
+ *
+ * Palettes that cannot be represented return null from encodePaletteFrame
+ * and are sent as JSON.
+ */
+
+export const PALETTE_FRAME_FORMAT = "binary-v1";
+export const PALETTE_FRAME_MAGIC = 0x50;
+export const PALETTE_FRAME_TYPE_PALETTE = 0x01;
+export const PALETTE_FRAME_FLAG_UUID = 0x01;
+export const PALETTE_FRAME_FLAG_SENT_AT = 0x02;
+
+// Limits match the device's fixed-size ColorPalette fields
+export const PALETTE_FRAME_MAX_COLORS = 10;
+export const PALETTE_FRAME_MAX_ID = 36;
+export const PALETTE_FRAME_MAX_NAME = 40;
+
+const HEADER_SIZE = 12;
+const UINT32_RANGE = 0x100000000;
+const UUID_PATTERN =
+  /^[0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12}$/i;
+const HEX_PATTERN = /^#?([0-9a-f]{6})$/i;
+
+export interface PaletteFrame {
+  messageId: string;
+  senderName: string;
+  timestamp: number;
+  sentAt?: number;
+  colors: { hex: string }[];
+}
+
+/**
+ * Palette timestamps arrive as Date, ISO string or epoch ms; devices get ms
+ */
+export function paletteTimestamp(value: any): number {
+  if (value instanceof Date) {
+    return value.getTime();
+  }
+  if (typeof value === "string") {
+    const parsed = Date.parse(value);
+    return isNaN(parsed) ? Date.now() : parsed;
+  }
+  return typeof value === "number" ? value : Date.now();
+}
+
+function writeUInt64(frame: Buffer, value: number, offset: number) {
+  const clamped = Math.max(0, Math.floor(value));
+  frame.writeUInt32LE(clamped % UINT32_RANGE, offset);
+  frame.writeUInt32LE(Math.floor(clamped / UINT32_RANGE), offset + 4);
+}
+
+function readUInt64(frame: Buffer, offset: number): number {
+  return (
+    frame.readUInt32LE(offset) + frame.readUInt32LE(offset + 4) * UINT32_RANGE
+  );
+}
+
+function colorHex(color: any): string | null {
+  const hex = typeof color === "string" ? color : color?.hex;
+  const match = typeof hex === "string" ? HEX_PATTERN.exec(hex) : null;
+  return match ? match[1] : null;
+}
+
+/**
+ * Encode a palette as a binary frame
+ * @param sentAt send time in ms since epoch, used for latency measurement
+ * @returns the frame, or null if the palette must be sent as JSON
+ */
+export function encodePaletteFrame(
+  palette: any,
+  sentAt?: number
+): Buffer | null {
+  const colors: any[] = Array.isArray(palette?.colors) ? palette.colors : [];
+  if (colors.length > PALETTE_FRAME_MAX_COLORS) {
+    return null;
+  }
+
+  const hexColors = colors.map(colorHex);
+  if (hexColors.some((hex) => hex === null)) {
+    return null;
+  }
+
+  const messageId = String(palette.messageId ?? "");
+  const packedId = UUID_PATTERN.test(messageId);
+  const idBytes = packedId
+    ? Buffer.from(messageId.replace(/-/g, ""), "hex")
+    : Buffer.from(messageId, "utf8");
+  const nameBytes = Buffer.from(String(palette.senderName ?? ""), "utf8");
+
+  if (
+    (!packedId && idBytes.length > PALETTE_FRAME_MAX_ID) ||
+    nameBytes.length > PALETTE_FRAME_MAX_NAME
+  ) {
+    return null;
+  }
+
+  const hasSentAt = sentAt !== undefined;
+  const size =
+    HEADER_SIZE +
+    (hasSentAt ? 8 : 0) +
+    (packedId ? idBytes.length : 1 + idBytes.length) +
+    1 +
+    nameBytes.length +
+    hexColors.length * 3;
+  const frame = Buffer.alloc(size);
+
+  frame.writeUInt8(PALETTE_FRAME_MAGIC, 0);
+  frame.writeUInt8(PALETTE_FRAME_TYPE_PALETTE, 1);
+  frame.writeUInt8(
+    (packedId ? PALETTE_FRAME_FLAG_UUID : 0) |
+      (hasSentAt ? PALETTE_FRAME_FLAG_SENT_AT : 0),
+    2
+  );
+  frame.writeUInt8(hexColors.length, 3);
+  writeUInt64(frame, paletteTimestamp(palette.timestamp), 4);
+
+  let offset = HEADER_SIZE;
+  if (sentAt !== undefined) {
+    writeUInt64(frame, sentAt, offset);
+    offset += 8;
+  }
+  if (!packedId) {
+    offset = frame.writeUInt8(idBytes.length, offset);
+  }
+  offset += idBytes.copy(frame, offset);
+  offset = frame.writeUInt8(nameBytes.length, offset);
+  offset += nameBytes.copy(frame, offset);
+
+  for (const hex of hexColors) {
+    offset += Buffer.from(hex, "hex").copy(frame, offset);
+  }
+
+  return frame;
+}
+
+/**
+ * Decode a binary palette frame
+ * @returns the palette, or null for malformed frames
+ */
+export function decodePaletteFrame(frame: Buffer): PaletteFrame | null {
+  if (
+    frame.length < HEADER_SIZE ||
+    frame.readUInt8(0) !== PALETTE_FRAME_MAGIC ||
+    frame.readUInt8(1) !== PALETTE_FRAME_TYPE_PALETTE
+  ) {
+    return null;
+  }
+
+  const flags = frame.readUInt8(2);
+  const colorCount = frame.readUInt8(3);
+  const timestamp = readUInt64(frame, 4);
+  let offset = HEADER_SIZE;
+
+  let sentAt: number | undefined;
+  if (flags & PALETTE_FRAME_FLAG_SENT_AT) {
+    if (offset + 8 > frame.length) {
+      return null;
+    }
+    sentAt = readUInt64(frame, offset);
+    offset += 8;
+  }
+
+  const readText = (): string | null => {
+    if (offset >= frame.length) {
+      return null;
+    }
+    const length = frame.readUInt8(offset++);
+    if (offset + length > frame.length) {
+      return null;
+    }
+    const text = frame.toString("utf8", offset, offset + length);
+    offset += length;
+    return text;
+  };
+
+  let messageId: string | null;
+  if (flags & PALETTE_FRAME_FLAG_UUID) {
+    if (offset + 16 > frame.length) {
+      return null;
+    }
+    const hex = frame.toString("hex", offset, offset + 16);
+    offset += 16;
+    messageId = `${hex.slice(0, 8)}-${hex.slice(8, 12)}-${hex.slice(12, 16)}-${hex.slice(16, 20)}-${hex.slice(20)}`;
+  } else {
+    messageId = readText();
+  }
+
+  const senderName = readText();
+  if (messageId === null || senderName === null) {
+    return null;
+  }
+
+  if (offset + colorCount * 3 !== frame.length) {
+    return null;
+  }
+
+  const colors: { hex: string }[] = [];
+  for (let i = 0; i < colorCount; i++) {
+    colors.push({ hex: `#${frame.toString("hex", offset, offset + 3)}` });
+    offset += 3;
+  }
+
+  const decoded: PaletteFrame = { messageId, senderName, timestamp, colors };
+  if (sentAt !== undefined) {
+    decoded.sentAt = sentAt;
+  }
+  return decoded;
+}
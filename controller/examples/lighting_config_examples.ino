@@ -93,7 +93,7 @@ void setupWS2812()
 
         // Test with a simple color display
         ColorPalette testPalette;
-        testPalette.name = "Test Colors";
+        testPalette.setName("Test Colors");
         testPalette.colorCount = 3;
         testPalette.colors[0] = {255, 0, 0}; // Red
         testPalette.colors[1] = {0, 255, 0}; // Green
@@ -133,7 +133,7 @@ void switchLightingSystem()
             defaultConfig.hostAddress,
             defaultConfig.port,
             defaultConfig.authToken,
-            defaultConfig.customConfig);
+            defaultConfig.customConfig.as<JsonObject>());
     }
 }
 
@@ -159,7 +159,8 @@ void advancedConfiguration()
         Serial.println("📊 Status: " + status);
 
         // Get capabilities
-        JsonObject caps = lightManager.getCapabilities();
+        JsonDocument caps;
+        lightManager.getCapabilities(caps.to<JsonObject>());
         Serial.println("⚡ Capabilities:");
         serializeJsonPretty(caps, Serial);
     }
@@ -207,7 +208,7 @@ void mainLoopExample()
 
         // Create example palette
         ColorPalette palette;
-        palette.name = "Demo Palette";
+        palette.setName("Demo Palette");
         palette.colorCount = 4;
         palette.colors[0] = {255, 100, 50}; // Orange
         palette.colors[1] = {100, 255, 50}; // Green
@@ -11,14 +11,100 @@
 #define DEFAULT_SERVER_URL "ws://cides06.gm.fh-koeln.de:3001/ws"
 
 // Timing constants
-#define WIFI_CONNECT_TIMEOUT 30000       // 30 seconds
+#define WIFI_CONNECT_TIMEOUT 30000       // 30 seconds per association attempt
 #define HEARTBEAT_INTERVAL 30000         // 30 seconds
 #define REGISTRATION_RETRY_INTERVAL 5000 // 5 seconds
 #define STATUS_UPDATE_INTERVAL 60000     // 1 minute
+#define STATUS_TELEMETRY_INTERVAL 300000 // Heap, RSSI, uptime, connection, loop and latency stats ride along every 5 minutes
+
+// Main loop scheduler (periods of the cooperative tasks in main.ino)
+#define LOOP_NETWORK_PERIOD 10      // WebSocket, HTTP and WiFi servicing; bounds palette pickup latency
+#define LOOP_STATE_PERIOD 50        // Device state machine
+#define LOOP_STATUS_PERIOD 1000     // Periodic status and registration checks
+#define LOOP_SCHEDULER_MAX_TASKS 8
+#define LOOP_SCHEDULER_MAX_SLEEP 1000 // Longest single sleep between passes
+#define LOOP_SLOW_THRESHOLD 100       // Passes or tasks blocking longer (ms) are logged and counted as slow
+#define LOOP_HISTOGRAM_BOUNDS 1, 5, 10, 50, 100, 500, 1000 // Bucket upper bounds in ms
+#define LOOP_CONTEXT_LENGTH 24        // Longest state name recorded with a slow pass
+
+// Inbound WebSocket message parsing
+#define WS_JSON_ARENA_SIZE 4096    // Bytes reserved for one parsed message
+#define WS_EVENT_NAME_LENGTH 32    // Longest event name
+#define WS_BINARY_PALETTE_FRAMES 1 // Offer binary palette frames during registration
+
+// WebSocket reconnect backoff (full jitter between 0 and the current ceiling)
+#define WS_RECONNECT_BACKOFF_BASE 1000   // Ceiling after the first failure
+#define WS_RECONNECT_BACKOFF_MAX 60000   // Ceiling never grows past a minute
+#define WS_RECONNECT_STABLE_TIME 30000   // Connections lasting this long reset the backoff
+
+// WebSocket ping/pong (pong timeout adapts to the measured RTT within these bounds)
+#define WS_PING_MAX_MISSED 3      // Consecutive missed pongs before the connection is declared dead
+#define WS_PONG_TIMEOUT_MIN 2000  // 2 seconds
+#define WS_PONG_TIMEOUT_MAX 10000 // 10 seconds, also used before the first RTT sample
+
+// Backend HTTP requests (DeviceManager) scale their timeout from the WebSocket RTT
+#define BACKEND_HTTP_RTT_FACTOR 4      // Connect, request, server time and response
+#define BACKEND_HTTP_TIMEOUT_MIN 3000  // 3 seconds
+#define BACKEND_HTTP_TIMEOUT_MAX 15000 // 15 seconds
+
+// Outbound WebSocket batching (messages from one loop pass share a frame)
+#define WS_OUTBOUND_BUFFER_SIZE 2048   // Bytes of queued messages per frame
+#define WS_OUTBOUND_SLOW_SEND 250      // A send blocking this long (ms) marks the socket congested
+#define WS_OUTBOUND_RETRY_INTERVAL 1000 // Hold back the next frame this long after a failed send
+
+// Palette latency tracking
+#define LATENCY_WINDOW_SIZE 32 // Palettes kept per stage for percentiles
+#define LATENCY_HISTOGRAM_BOUNDS 50, 100, 200, 500, 1000, 2000, 5000 // Bucket upper bounds in ms
+#define TIME_SYNC_MAX_RTT 2000 // Discard clock samples with a slower round trip
+
+// HTTP transport (shared by light controllers and DeviceManager)
+#define HTTP_TRANSPORT_MAX_SLOTS 4         // Concurrent connections overall
+#define HTTP_TRANSPORT_SLOTS_PER_HOST 1    // Concurrent connections per host
+#define HTTP_TRANSPORT_QUEUE_SIZE 8        // Requests waiting for a slot
+#define HTTP_TRANSPORT_DEFAULT_TIMEOUT 5000 // 5 seconds
+#define HTTP_TRANSPORT_MAX_RESPONSE 16384  // Largest buffered response body
+#define LIGHT_HTTP_TIMEOUT 2000            // 2 seconds for LAN light requests
+#define HTTP_TRANSPORT_TLS_STACK_SIZE 8192 // Worker task for one https:// request (mbedTLS handshake)
+#define HTTP_TRANSPORT_TLS_PRIORITY 1
+// #define BACKEND_TLS_CA_CERT "-----BEGIN CERTIFICATE-----\n..." // Verify the backend certificate (PEM)
+
+// Lighting targets (primary system plus additional ones driven in parallel)
+#define MAX_LIGHT_TARGETS 4
+
+// Lighting target health (circuit breaker with background probe)
+#define LIGHT_HEALTH_FAILURE_THRESHOLD 2 // Consecutive failures before a target is considered down
+#define LIGHT_HEALTH_BACKOFF_BASE 2000   // First probe 2 seconds after the circuit opens
+#define LIGHT_HEALTH_BACKOFF_MAX 60000   // Probe a dead target at least once a minute
+#define LIGHT_HEALTH_PROBE_TIMEOUT 1500  // Probes only check reachability
+
+// Last displayed palette, persisted for power-on restore
+#define LIGHT_PALETTE_STORE_DELAY 2000 // Flash write waits this long after a display, and for idle lights
+
+// Lighting task (runs all LightManager work off the WebSocket loop)
+#define LIGHTING_TASK_STACK_SIZE 8192
+#define LIGHTING_TASK_PRIORITY 1
+#define LIGHTING_COMMAND_QUEUE_SIZE 4
+#define LIGHTING_EVENT_QUEUE_SIZE 8
+
+// Long-running WebSocket commands (reported as jobProgress/jobCompleted)
+#define MAX_JOBS 4
+#define JOB_TIMEOUT 120000        // 2 minutes; Nanoleaf discovery plus pairing can take a minute
+#define FACTORY_RESET_GRACE 500   // Time for the acknowledgment to leave before the reset
+
+// Boot timeline (reported under "boot" in deviceStatus)
+#define BOOT_TIMELINE_MAX_ENTRIES 24
+#define BOOT_TIMELINE_NAME_LENGTH 24
 
 // Network constants
 #define MAX_WIFI_RETRY_ATTEMPTS 3
+#define WIFI_RECONNECT_DELAY_BASE 1000  // Delay before the first retry, doubled per failure
+#define WIFI_RECONNECT_DELAY_MAX 30000  // Retry delay never grows past 30 seconds
+#define WIFI_FAST_CONNECT_TIMEOUT 5000  // Directed connect to the cached BSSID/channel before a full scan
+#define WIFI_FAST_CONNECT_STATIC_IP 0   // Reuse this boot's DHCP lease on fast reconnects instead of asking DHCP again
+#define WIFI_FAST_CONNECT_LEASE_TIME 3600000 // Reuse the lease only this long after DHCP handed it out; keep below the router's lease time
+#define WIFI_CONNECT_CACHE_VERSION 2
 #define CAPTIVE_PORTAL_TIMEOUT 300000 // 5 minutes
+#define CAPTIVE_PORTAL_RESTART_DELAY 2000 // Lets the portal's reply reach the browser before restarting
 
 // Hardware pins (if needed for future LED integration)
 #define LED_DATA_PIN 2
@@ -37,9 +123,12 @@
 #define DEVICE_PREF_NAMESPACE "palpalette"
 #define PREF_WIFI_SSID "wifi_ssid"
 #define PREF_WIFI_PASSWORD "wifi_pass"
+#define PREF_WIFI_CONNECT_CACHE "wifi_fast"
 #define PREF_SERVER_URL "server_url"
 #define PREF_DEVICE_ID "device_id"
 #define PREF_IS_PROVISIONED "provisioned"
 #define PREF_MAC_ADDRESS "mac_addr"
+#define PREF_SESSION_TOKEN "ws_session"
+#define PREF_REGISTRATION_HASH "reg_hash"
 
 #endif
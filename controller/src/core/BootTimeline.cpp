@@ -0,0 +1,117 @@
+#include "BootTimeline.h"
+
+BootTimeline::BootTimeline() : count(0), dropped(0), completed(false), operationalAt(0)
+{
+}
+
+void BootTimeline::phase(const char *name)
+{
+    add(name, millis(), 0, true);
+}
+
+void BootTimeline::step(const char *name, unsigned long startedAt)
+{
+    unsigned long now = millis();
+    add(name, now, now - startedAt, false);
+}
+
+void BootTimeline::step(const char *name, unsigned long finishedAt, unsigned long durationMs)
+{
+    add(name, finishedAt, durationMs, false);
+}
+
+void BootTimeline::complete()
+{
+    if (completed)
+    {
+        return;
+    }
+
+    completed = true;
+    operationalAt = millis();
+    Serial.printf("⏱ Operational %lu ms after boot (type 'boot' for the timeline)\n", operationalAt);
+}
+
+void BootTimeline::add(const char *name, unsigned long at, unsigned long durationMs, bool isPhase)
+{
+    if (completed)
+    {
+        return;
+    }
+    if (count >= BOOT_TIMELINE_MAX_ENTRIES)
+    {
+        dropped++;
+        return;
+    }
+
+    Entry &entry = entries[count++];
+    strlcpy(entry.name, name, sizeof(entry.name));
+    entry.at = at;
+    entry.durationMs = durationMs;
+    entry.isPhase = isPhase;
+}
+
+unsigned long BootTimeline::phaseDuration(int index) const
+{
+    for (int i = index + 1; i < count; i++)
+    {
+        if (entries[i].isPhase)
+        {
+            return entries[i].at - entries[index].at;
+        }
+    }
+    // The last phase runs until operational, or is still running
+    return (completed ? operationalAt : millis()) - entries[index].at;
+}
+
+void BootTimeline::report(JsonObject out) const
+{
+    out["complete"] = completed;
+    if (completed)
+    {
+        out["timeToOperationalMs"] = operationalAt;
+    }
+    if (dropped)
+    {
+        out["dropped"] = dropped;
+    }
+
+    JsonArray phases = out["phases"].to<JsonArray>();
+    JsonArray steps = out["steps"].to<JsonArray>();
+    for (int i = 0; i < count; i++)
+    {
+        const Entry &entry = entries[i];
+        JsonObject item = entry.isPhase ? phases.add<JsonObject>() : steps.add<JsonObject>();
+        item["name"] = entry.name;
+        item["at"] = entry.at;
+        // A running phase's duration would change with every report
+        if (!entry.isPhase || completed)
+        {
+            item["ms"] = entry.isPhase ? phaseDuration(i) : entry.durationMs;
+        }
+    }
+}
+
+void BootTimeline::print() const
+{
+    Serial.println("⏱ Boot Timeline:");
+    Serial.println("  at ms    duration  entry");
+    for (int i = 0; i < count; i++)
+    {
+        const Entry &entry = entries[i];
+        Serial.printf("  %7lu %8lu ms  %s%s\n", entry.at, entry.isPhase ? phaseDuration(i) : entry.durationMs,
+                      entry.isPhase ? "▶ " : "  ", entry.name);
+    }
+    if (dropped)
+    {
+        Serial.printf("  (%u entries dropped)\n", dropped);
+    }
+    if (completed)
+    {
+        Serial.printf("  time to operational: %lu ms\n", operationalAt);
+    }
+    else
+    {
+        Serial.printf("  not operational yet (%lu ms since boot)\n", millis());
+    }
+}
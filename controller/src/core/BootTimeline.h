@@ -0,0 +1,68 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+
+/**
+ * Cold-start timeline from power-on to the first operational state
+ *
+ * Records every state machine phase and every blocking step (WiFi
+ * association, HTTP registration, WebSocket connect, ...) with its
+ * millis() timestamp and duration. Recording stops once the device first
+ * becomes operational, so later reconnects do not blur the boot numbers.
+ * The timeline goes out in deviceStatus under "boot" and is printed by the
+ * "boot" serial command.
+ */
+class BootTimeline
+{
+public:
+    BootTimeline();
+
+    /**
+     * The state machine entered a new phase
+     */
+    void phase(const char *name);
+
+    /**
+     * A blocking step that began at startedAt has just finished
+     */
+    void step(const char *name, unsigned long startedAt);
+
+    /**
+     * A step that took durationMs and finished at finishedAt
+     */
+    void step(const char *name, unsigned long finishedAt, unsigned long durationMs);
+
+    /**
+     * First operational state reached; freezes the timeline
+     */
+    void complete();
+
+    bool isComplete() const { return completed; }
+    unsigned long getTimeToOperationalMs() const { return operationalAt; }
+
+    void report(JsonObject out) const;
+    void print() const;
+
+private:
+    struct Entry
+    {
+        char name[BOOT_TIMELINE_NAME_LENGTH];
+        unsigned long at;         // millis() when the phase began or the step finished
+        unsigned long durationMs; // Steps only; phases last until the next phase
+        bool isPhase;
+    };
+
+    Entry entries[BOOT_TIMELINE_MAX_ENTRIES];
+    int count;
+    uint16_t dropped;
+    bool completed;
+    unsigned long operationalAt;
+
+    void add(const char *name, unsigned long at, unsigned long durationMs, bool isPhase);
+    unsigned long phaseDuration(int index) const;
+};
+
+#endif
@@ -1,9 +1,11 @@
 #include "DeviceManager.h"
 #include "config.h"
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
 
-DeviceManager::DeviceManager() : lastStatusUpdate(0)
+DeviceManager::DeviceManager()
+    : lastStatusUpdate(0), httpTransport(nullptr), backendTimeoutMs(0), registrationState(REGISTRATION_IDLE),
+      registrationStartedAt(0), registrationFinishedAt(0), registrationSkipped(false), identityLoaded(false),
+      identityHash(0), registrationHash(0), storedRegistrationHash(0)
 {
 }
 
@@ -17,6 +19,8 @@ void DeviceManager::begin()
         generateDeviceInfo();
         saveDeviceInfo();
     }
+    sessionToken = preferences.getString(PREF_SESSION_TOKEN, "");
+    storedRegistrationHash = preferences.getUInt(PREF_REGISTRATION_HASH, 0);
 
     Serial.println("📱 DeviceManager initialized");
     Serial.println("🆔 Device ID: " + deviceInfo.deviceId);
@@ -117,45 +121,14 @@ bool DeviceManager::loadDeviceInfo()
     return true;
 }
 
-bool DeviceManager::registerWithServer(const String &serverUrl)
+void DeviceManager::loadRegistrationIdentity()
 {
-    if (serverUrl.length() == 0)
-    {
-        Serial.println("❌ No server URL provided for registration");
-        return false;
-    }
-
-    // Convert WebSocket URL to HTTP URL for registration
-    String httpUrl = serverUrl;
-    httpUrl.replace("ws://", "http://");
-    httpUrl.replace("wss://", "https://");
-
-    // Remove port if it's the WebSocket port, add API endpoint
-    int portIndex = httpUrl.lastIndexOf(':');
-    if (portIndex > 7)
-    { // After http://
-        String baseUrl = httpUrl.substring(0, portIndex);
-        httpUrl = baseUrl + ":3000/devices/register"; // Assume API is on port 3000
-    }
-    else
-    {
-        httpUrl += "/devices/register";
-    }
-
-    HTTPClient http;
-    http.begin(httpUrl);
-    http.addHeader("Content-Type", "application/json");
-
-    // Prepare registration data
-    JsonDocument doc;
+    JsonDocument &doc = registrationIdentity;
+    doc.clear();
     doc["macAddress"] = deviceInfo.macAddress;
     doc["deviceType"] = DEVICE_TYPE;
     doc["firmwareVersion"] = deviceInfo.firmwareVersion;
 
-    // Update IP address
-    deviceInfo.ipAddress = WiFi.localIP().toString();
-    doc["ipAddress"] = deviceInfo.ipAddress;
-
     // Include lighting configuration if available
     Preferences lightingPrefs;
     lightingPrefs.begin("light_config", true); // Use same namespace as LightManager
@@ -193,6 +166,66 @@ bool DeviceManager::registerWithServer(const String &serverUrl)
     }
     lightingPrefs.end();
 
+    String identity;
+    serializeJson(doc, identity);
+    identityHash = fnv1a(identity);
+    identityLoaded = true;
+}
+
+bool DeviceManager::buildRegistrationRequest(const String &serverUrl, HttpRequest &request)
+{
+    if (serverUrl.length() == 0)
+    {
+        Serial.println("❌ No server URL provided for registration");
+        return false;
+    }
+
+    // Convert WebSocket URL to HTTP URL for registration
+    String httpUrl = serverUrl;
+    httpUrl.replace("ws://", "http://");
+    httpUrl.replace("wss://", "https://");
+
+    // Remove port if it's the WebSocket port, add API endpoint
+    int portIndex = httpUrl.lastIndexOf(':');
+    if (portIndex > 7)
+    { // After http://
+        String baseUrl = httpUrl.substring(0, portIndex);
+        httpUrl = baseUrl + ":3000/devices/register"; // Assume API is on port 3000
+    }
+    else
+    {
+        httpUrl += "/devices/register";
+    }
+
+    if (!httpTransport)
+    {
+        Serial.println("❌ No HTTP transport available for registration");
+        return false;
+    }
+
+    if (!request.setUrl(httpUrl))
+    {
+        Serial.println("❌ Unsupported registration URL: " + httpUrl);
+        return false;
+    }
+    request.method = "POST";
+    request.timeoutMs = backendTimeoutMs;
+
+    // Prepare registration data. Identity and lighting configuration are
+    // read from NVS once and cached until invalidateRegistrationPayload().
+    if (!identityLoaded)
+    {
+        loadRegistrationIdentity();
+    }
+    JsonDocument doc;
+    doc.set(registrationIdentity);
+
+    // Update IP address (not part of the hash: the WebSocket registration
+    // and status reports carry it too)
+    deviceInfo.ipAddress = WiFi.localIP().toString();
+    doc["ipAddress"] = deviceInfo.ipAddress;
+    registrationHash = fnv1a(serverUrl, identityHash);
+
     String payload;
     serializeJson(doc, payload);
 
@@ -200,11 +233,73 @@ bool DeviceManager::registerWithServer(const String &serverUrl)
     Serial.println("🌐 URL: " + httpUrl);
     Serial.println("📦 Payload: " + payload);
 
-    int httpResponseCode = http.POST(payload);
+    request.body = payload;
+    return true;
+}
+
+bool DeviceManager::startRegistration(const String &serverUrl)
+{
+    if (registrationState == REGISTRATION_PENDING)
+    {
+        return true;
+    }
+
+    HttpRequest request;
+    if (!buildRegistrationRequest(serverUrl, request))
+    {
+        registrationState = REGISTRATION_FAILED;
+        return false;
+    }
+
+    registrationStartedAt = millis();
+    registrationSkipped = false;
+
+    // The backend already has exactly this registration; the WebSocket
+    // registration is enough unless the backend rejects it
+    if (storedRegistrationHash != 0 && registrationHash == storedRegistrationHash)
+    {
+        Serial.println("⚡ Registration unchanged since the last one, skipping HTTP registration");
+        registrationSkipped = true;
+        registrationFinishedAt = registrationStartedAt;
+        registrationState = REGISTRATION_SUCCEEDED;
+        return true;
+    }
+
+    // Completes from HttpTransport::loop() on this task
+    uint32_t hash = registrationHash;
+    request.callback = [this, hash](const HttpResponse &result)
+    {
+        registrationFinishedAt = millis();
+        if (handleRegistrationResponse(result))
+        {
+            registrationState = REGISTRATION_SUCCEEDED;
+            storedRegistrationHash = hash;
+            preferences.putUInt(PREF_REGISTRATION_HASH, hash);
+        }
+        else
+        {
+            registrationState = REGISTRATION_FAILED;
+        }
+    };
+
+    if (httpTransport->send(request) == 0)
+    {
+        Serial.println("❌ Registration request could not be queued");
+        registrationState = REGISTRATION_FAILED;
+        return false;
+    }
+
+    registrationState = REGISTRATION_PENDING;
+    return true;
+}
+
+bool DeviceManager::handleRegistrationResponse(const HttpResponse &result)
+{
+    int httpResponseCode = result.statusCode;
 
     if (httpResponseCode == 200 || httpResponseCode == 201)
     {
-        String response = http.getString();
+        const String &response = result.body;
         Serial.println("✅ Device registered successfully!");
         // Only print first 200 chars of response to avoid memory issues
         if (response.length() > 200)
@@ -251,7 +346,6 @@ bool DeviceManager::registerWithServer(const String &serverUrl)
         }
 
         saveDeviceInfo();
-        http.end();
         return true;
     }
     else
@@ -260,9 +354,8 @@ bool DeviceManager::registerWithServer(const String &serverUrl)
         Serial.println("📊 HTTP Response Code: " + String(httpResponseCode));
         if (httpResponseCode > 0)
         {
-            Serial.println("📨 Response: " + http.getString());
+            Serial.println("📨 Response: " + result.body);
         }
-        http.end();
         return false;
     }
 }
@@ -290,9 +383,19 @@ bool DeviceManager::updateStatus(const String &serverUrl)
         httpUrl += "/devices/" + deviceInfo.deviceId + "/status";
     }
 
-    HTTPClient http;
-    http.begin(httpUrl);
-    http.addHeader("Content-Type", "application/json");
+    if (!httpTransport)
+    {
+        return false;
+    }
+
+    HttpRequest request;
+    if (!request.setUrl(httpUrl))
+    {
+        return false;
+    }
+    request.method = "PUT";
+    request.timeoutMs = backendTimeoutMs;
+    request.discardBody = true;
 
     JsonDocument doc;
     doc["isOnline"] = true;
@@ -304,16 +407,27 @@ bool DeviceManager::updateStatus(const String &serverUrl)
     String payload;
     serializeJson(doc, payload);
 
-    int httpResponseCode = http.PUT(payload);
-    http.end();
+    request.body = payload;
+    request.callback = [](const HttpResponse &response)
+    {
+        if (response.statusCode == 200)
+        {
+            Serial.println("📊 Device status updated successfully");
+        }
+        else
+        {
+            Serial.println("⚠️ Device status update failed: " + String(response.statusCode));
+        }
+    };
 
-    if (httpResponseCode == 200)
+    if (httpTransport->send(request) == 0)
     {
-        markStatusUpdated();
-        return true;
+        return false;
     }
 
-    return false;
+    // Mark at dispatch so a slow server is not flooded with overlapping updates
+    markStatusUpdated();
+    return true;
 }
 
 void DeviceManager::setProvisioned(bool provisioned)
@@ -351,6 +465,11 @@ String DeviceManager::getPairingCode()
     return deviceInfo.pairingCode;
 }
 
+void DeviceManager::setPairingCode(const String &code)
+{
+    deviceInfo.pairingCode = code;
+}
+
 DeviceInfo DeviceManager::getDeviceInfo()
 {
     return deviceInfo;
@@ -362,6 +481,9 @@ void DeviceManager::resetDevice()
 
     // Clear all stored data
     preferences.clear();
+    sessionToken = "";
+    storedRegistrationHash = 0;
+    identityLoaded = false;
 
     // Regenerate device info
     generateDeviceInfo();
@@ -372,6 +494,46 @@ void DeviceManager::resetDevice()
     Serial.println("🔑 New Pairing Code: " + deviceInfo.pairingCode);
 }
 
+void DeviceManager::invalidateRegistration()
+{
+    if (storedRegistrationHash == 0)
+    {
+        return;
+    }
+
+    storedRegistrationHash = 0;
+    preferences.remove(PREF_REGISTRATION_HASH);
+    Serial.println("🗑 Cached registration dropped, next registration goes over HTTP");
+}
+
+uint32_t DeviceManager::fnv1a(const String &value, uint32_t hash)
+{
+    for (size_t i = 0; i < value.length(); i++)
+    {
+        hash = (hash ^ (uint8_t)value[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void DeviceManager::setSessionToken(const String &token)
+{
+    // Tokens only change on a full registration, so NVS is rarely written
+    if (token == sessionToken)
+    {
+        return;
+    }
+
+    sessionToken = token;
+    if (token.length() > 0)
+    {
+        preferences.putString(PREF_SESSION_TOKEN, token);
+    }
+    else
+    {
+        preferences.remove(PREF_SESSION_TOKEN);
+    }
+}
+
 bool DeviceManager::shouldUpdateStatus()
 {
     return (millis() - lastStatusUpdate) > STATUS_UPDATE_INTERVAL;
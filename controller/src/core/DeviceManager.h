@@ -6,6 +6,7 @@
 #include <Preferences.h>
 #include <WiFi.h>
 #include "../config.h"
+#include "HttpTransport.h"
 
 struct DeviceInfo
 {
@@ -18,33 +19,86 @@ struct DeviceInfo
     String firmwareVersion;
 };
 
+enum RegistrationState
+{
+    REGISTRATION_IDLE,
+    REGISTRATION_PENDING, // POST /devices/register in flight
+    REGISTRATION_SUCCEEDED,
+    REGISTRATION_FAILED
+};
+
 class DeviceManager
 {
 private:
     Preferences preferences;
     DeviceInfo deviceInfo;
     unsigned long lastStatusUpdate;
+    HttpTransport *httpTransport;
+    String sessionToken; // Resumable WebSocket session issued by the backend
+    unsigned long backendTimeoutMs; // 0 = HTTP_TRANSPORT_DEFAULT_TIMEOUT
+    RegistrationState registrationState;
+    unsigned long registrationStartedAt;
+    unsigned long registrationFinishedAt;
+    bool registrationSkipped;
+
+    // Registration payload without the IP address, read from NVS once
+    JsonDocument registrationIdentity;
+    bool identityLoaded;
+    uint32_t identityHash;
+    uint32_t registrationHash;       // identityHash combined with the server URL
+    uint32_t storedRegistrationHash; // Hash of the last registration the backend accepted, 0 if none
 
     void generateDeviceInfo();
     bool saveDeviceInfo();
     bool loadDeviceInfo();
+    void loadRegistrationIdentity();
+    bool buildRegistrationRequest(const String &serverUrl, HttpRequest &request);
+    static uint32_t fnv1a(const String &value, uint32_t hash = 2166136261u);
+    bool handleRegistrationResponse(const HttpResponse &result);
 
 public:
     DeviceManager();
 
     void begin();
-    bool registerWithServer(const String &serverUrl);
-    bool updateStatus(const String &serverUrl);
+    void setHttpTransport(HttpTransport *transport) { httpTransport = transport; }
+    void setBackendTimeout(unsigned long timeoutMs) { backendTimeoutMs = timeoutMs; } // From the WebSocket RTT
+
+    /**
+     * Queue the HTTP registration; returns immediately so the WebSocket
+     * connection can be opened while it is in flight. Completes at once,
+     * without a request, when the payload hash matches the last
+     * registration the backend accepted.
+     * @return false when the request could not be queued
+     */
+    bool startRegistration(const String &serverUrl);
+    RegistrationState getRegistrationState() const { return registrationState; }
+    unsigned long getRegistrationStartedAt() const { return registrationStartedAt; }
+    unsigned long getRegistrationFinishedAt() const { return registrationFinishedAt; }
+    bool wasRegistrationSkipped() const { return registrationSkipped; }
+
+    // Lighting configuration changed: rebuild the payload on the next registration
+    void invalidateRegistrationPayload() { identityLoaded = false; }
+
+    // Backend rejected the cached registration: the next one goes over HTTP
+    void invalidateRegistration();
+
+    bool updateStatus(const String &serverUrl); // HTTP fallback while the WebSocket is down; result is logged when it completes
     void setProvisioned(bool provisioned);
     bool isProvisioned();
     String getDeviceId();
     String getMacAddress();
     String getPairingCode();
+    void setPairingCode(const String &code); // Assigned by the backend, replaces the MAC-derived code
     DeviceInfo getDeviceInfo();
     void resetDevice();
     bool shouldUpdateStatus();
     void markStatusUpdated();
 
+    // WebSocket session token; kept in NVS so a reboot can resume as well
+    String getSessionToken() { return sessionToken; }
+    bool hasSession() { return sessionToken.length() > 0; }
+    void setSessionToken(const String &token);
+
     // Status update helpers
     void setOnlineStatus(bool online);
     bool isOnline();
@@ -0,0 +1,675 @@
+#include "HttpTransport.h"
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <memory>
+
+bool HttpRequest::setUrl(const String &url)
+{
+    String rest;
+    if (url.startsWith("http://"))
+    {
+        secure = false;
+        rest = url.substring(7);
+    }
+    else if (url.startsWith("https://"))
+    {
+        secure = true;
+        rest = url.substring(8);
+    }
+    else
+    {
+        return false;
+    }
+
+    int pathIndex = rest.indexOf('/');
+    String authority = pathIndex >= 0 ? rest.substring(0, pathIndex) : rest;
+    path = pathIndex >= 0 ? rest.substring(pathIndex) : String("/");
+
+    int portIndex = authority.indexOf(':');
+    if (portIndex >= 0)
+    {
+        host = authority.substring(0, portIndex);
+        port = authority.substring(portIndex + 1).toInt();
+    }
+    else
+    {
+        host = authority;
+        port = secure ? 443 : 80;
+    }
+
+    return host.length() > 0 && port > 0;
+}
+
+HttpTransport::HttpTransport() : queueHead(0), queueCount(0), nextId(1)
+{
+    mutex = xSemaphoreCreateRecursiveMutex();
+
+    for (int i = 0; i < HTTP_TRANSPORT_MAX_SLOTS; i++)
+    {
+        slots[i].state = SLOT_FREE;
+        slots[i].client = nullptr;
+    }
+}
+
+HttpTransport::~HttpTransport()
+{
+    lock();
+    for (int i = 0; i < HTTP_TRANSPORT_MAX_SLOTS; i++)
+    {
+        AsyncClient *client = slots[i].client;
+        slots[i].client = nullptr;
+        slots[i].state = SLOT_FREE;
+        if (client)
+        {
+            client->close(true);
+        }
+    }
+    unlock();
+    vSemaphoreDelete(mutex);
+}
+
+void HttpTransport::lock()
+{
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+}
+
+void HttpTransport::unlock()
+{
+    xSemaphoreGiveRecursive(mutex);
+}
+
+uint32_t HttpTransport::send(const HttpRequest &request)
+{
+    if (request.host.length() == 0 || request.port == 0)
+    {
+        Serial.println("❌ HTTP transport: request without host");
+        return 0;
+    }
+
+    lock();
+
+    if (queueCount >= HTTP_TRANSPORT_QUEUE_SIZE)
+    {
+        unlock();
+        Serial.println("⚠ HTTP transport queue full, dropping " + request.method + " " + request.host + request.path);
+        return 0;
+    }
+
+    uint32_t id = nextId++;
+    if (nextId == 0)
+    {
+        nextId = 1;
+    }
+
+    QueuedRequest &queued = queue[(queueHead + queueCount) % HTTP_TRANSPORT_QUEUE_SIZE];
+    queued.request = request;
+    queued.id = id;
+    queued.owner = xTaskGetCurrentTaskHandle();
+    queueCount++;
+
+    // Start immediately when a slot is available so callers that never
+    // reach loop() in between still get their request on the wire
+    startQueued();
+
+    unlock();
+    return id;
+}
+
+HttpResponse HttpTransport::execute(HttpRequest request)
+{
+    // Shared with the callback so a late completion never touches a dead stack frame
+    struct SyncState
+    {
+        volatile bool done = false;
+        HttpResponse response;
+    };
+    std::shared_ptr<SyncState> state = std::make_shared<SyncState>();
+
+    request.callback = [state](const HttpResponse &response)
+    {
+        state->response = response;
+        state->done = true;
+    };
+
+    if (send(request) == 0)
+    {
+        HttpResponse rejected;
+        rejected.statusCode = HTTP_TRANSPORT_ERROR_INVALID;
+        return rejected;
+    }
+
+    while (!state->done)
+    {
+        loop();
+        if (!state->done)
+        {
+            delay(1);
+        }
+    }
+
+    return state->response;
+}
+
+void HttpTransport::loop()
+{
+    struct Completion
+    {
+        HttpCallback callback;
+        HttpResponse response;
+    };
+    Completion completions[HTTP_TRANSPORT_MAX_SLOTS];
+    int completionCount = 0;
+
+    lock();
+
+    TaskHandle_t currentTask = xTaskGetCurrentTaskHandle();
+    unsigned long now = millis();
+    for (int i = 0; i < HTTP_TRANSPORT_MAX_SLOTS; i++)
+    {
+        Slot &slot = slots[i];
+
+        if (slot.state == SLOT_CONNECTING || slot.state == SLOT_ACTIVE)
+        {
+            unsigned long timeout = slot.request.timeoutMs > 0 ? slot.request.timeoutMs : HTTP_TRANSPORT_DEFAULT_TIMEOUT;
+            if (now - slot.startedAt > timeout)
+            {
+                finishSlot(slot, HTTP_TRANSPORT_ERROR_TIMEOUT);
+            }
+        }
+
+        if (slot.state == SLOT_DONE)
+        {
+            // Detach first: the disconnect handler frees clients it no longer owns
+            AsyncClient *client = slot.client;
+            slot.client = nullptr;
+            if (client)
+            {
+                client->close(true);
+            }
+
+            // Leave the result for the task that sent the request
+            if (slot.owner != currentTask)
+            {
+                continue;
+            }
+
+            completions[completionCount].callback = slot.request.callback;
+            completions[completionCount].response = slot.response;
+            completionCount++;
+
+            slot.request = HttpRequest();
+            slot.tx = String();
+            slot.rx = String();
+            slot.response = HttpResponse();
+            slot.state = SLOT_FREE;
+        }
+    }
+
+    startQueued();
+
+    unlock();
+
+    // Callbacks run without the lock so they may queue follow-up requests
+    for (int i = 0; i < completionCount; i++)
+    {
+        if (completions[i].callback)
+        {
+            completions[i].callback(completions[i].response);
+        }
+    }
+}
+
+int HttpTransport::pendingCount()
+{
+    lock();
+    int count = queueCount;
+    for (int i = 0; i < HTTP_TRANSPORT_MAX_SLOTS; i++)
+    {
+        if (slots[i].state != SLOT_FREE)
+        {
+            count++;
+        }
+    }
+    unlock();
+    return count;
+}
+
+void HttpTransport::startQueued()
+{
+    // Walk the queue in FIFO order, skipping hosts that are already at their limit
+    int remaining = queueCount;
+    int index = queueHead;
+    int kept = 0;
+    QueuedRequest deferred[HTTP_TRANSPORT_QUEUE_SIZE];
+
+    while (remaining-- > 0)
+    {
+        QueuedRequest &queued = queue[index];
+        index = (index + 1) % HTTP_TRANSPORT_QUEUE_SIZE;
+
+        Slot *freeSlot = nullptr;
+        for (int i = 0; i < HTTP_TRANSPORT_MAX_SLOTS; i++)
+        {
+            if (slots[i].state == SLOT_FREE)
+            {
+                freeSlot = &slots[i];
+                break;
+            }
+        }
+
+        if (freeSlot && activeForHost(queued.request.host, queued.request.port) < HTTP_TRANSPORT_SLOTS_PER_HOST)
+        {
+            startSlot(*freeSlot, queued);
+        }
+        else
+        {
+            deferred[kept++] = queued;
+        }
+    }
+
+    for (int i = 0; i < kept; i++)
+    {
+        queue[i] = deferred[i];
+    }
+    for (int i = kept; i < queueCount; i++)
+    {
+        queue[i] = QueuedRequest();
+    }
+    queueHead = 0;
+    queueCount = kept;
+}
+
+int HttpTransport::activeForHost(const String &host, uint16_t port)
+{
+    int count = 0;
+    for (int i = 0; i < HTTP_TRANSPORT_MAX_SLOTS; i++)
+    {
+        if (slots[i].state != SLOT_FREE && slots[i].request.port == port && slots[i].request.host == host)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool HttpTransport::startSlot(Slot &slot, const QueuedRequest &queued)
+{
+    slot.request = queued.request;
+    slot.id = queued.id;
+    slot.owner = queued.owner;
+    slot.startedAt = millis();
+    slot.txOffset = 0;
+    slot.rx = String();
+    slot.statusCode = 0;
+    slot.headerEnd = -1;
+    slot.contentLength = -1;
+    slot.chunked = false;
+    slot.response = HttpResponse();
+
+    if (slot.request.secure)
+    {
+        return startSecure(slot);
+    }
+
+    // Build the complete request up front so onConnect only has to write it
+    slot.tx = slot.request.method + " " + slot.request.path + " HTTP/1.1\r\n";
+    slot.tx += "Host: " + slot.request.host + ":" + String(slot.request.port) + "\r\n";
+    slot.tx += "User-Agent: PalPalette-ESP32\r\n";
+    slot.tx += "Connection: close\r\n";
+    if (slot.request.body.length() > 0 || slot.request.method == "POST" || slot.request.method == "PUT")
+    {
+        slot.tx += "Content-Type: application/json\r\n";
+        slot.tx += "Content-Length: " + String(slot.request.body.length()) + "\r\n";
+    }
+    slot.tx += slot.request.headers;
+    slot.tx += "\r\n";
+    slot.tx += slot.request.body;
+
+    AsyncClient *client = new AsyncClient();
+    if (!client)
+    {
+        slot.state = SLOT_DONE;
+        slot.response.statusCode = HTTP_TRANSPORT_ERROR_CONNECT;
+        return false;
+    }
+
+    Slot *slotPtr = &slot;
+    client->onConnect([this, slotPtr](void *, AsyncClient *c)
+                      { onConnect(slotPtr, c); });
+    client->onData([this, slotPtr](void *, AsyncClient *c, void *data, size_t len)
+                   { onData(slotPtr, c, data, len); });
+    client->onAck([this, slotPtr](void *, AsyncClient *c, size_t, uint32_t)
+                  { onAck(slotPtr, c); });
+    client->onError([this, slotPtr](void *, AsyncClient *c, int8_t error)
+                    { onError(slotPtr, c, error); });
+    client->onDisconnect([this, slotPtr](void *, AsyncClient *c)
+                         { onDisconnect(slotPtr, c); });
+
+    slot.client = client;
+    slot.state = SLOT_CONNECTING;
+
+    if (!client->connect(slot.request.host.c_str(), slot.request.port))
+    {
+        // Synchronous failure (e.g. DNS or no route): detach before freeing so a
+        // late error event cannot reach the disconnect handler for this client
+        slot.client = nullptr;
+        client->onError(nullptr);
+        client->onDisconnect(nullptr);
+        delete client;
+        finishSlot(slot, HTTP_TRANSPORT_ERROR_CONNECT);
+        return false;
+    }
+
+    return true;
+}
+
+bool HttpTransport::startSecure(Slot &slot)
+{
+    SecureJob *job = new SecureJob();
+    job->transport = this;
+    job->slot = &slot;
+    job->id = slot.id;
+    job->request = slot.request;
+    job->request.callback = nullptr; // Stays with the slot and runs on the owner's task
+
+    slot.client = nullptr;
+    slot.state = SLOT_ACTIVE;
+
+    if (xTaskCreate(secureTaskEntry, "httpsRequest", HTTP_TRANSPORT_TLS_STACK_SIZE, job,
+                    HTTP_TRANSPORT_TLS_PRIORITY, nullptr) != pdPASS)
+    {
+        delete job;
+        finishSlot(slot, HTTP_TRANSPORT_ERROR_CONNECT);
+        return false;
+    }
+    return true;
+}
+
+void HttpTransport::secureTaskEntry(void *param)
+{
+    SecureJob *job = static_cast<SecureJob *>(param);
+    job->transport->runSecure(*job);
+    delete job;
+    vTaskDelete(nullptr);
+}
+
+void HttpTransport::runSecure(SecureJob &job)
+{
+    const HttpRequest &request = job.request;
+    unsigned long timeout = request.timeoutMs > 0 ? request.timeoutMs : HTTP_TRANSPORT_DEFAULT_TIMEOUT;
+
+    WiFiClientSecure client;
+#ifdef BACKEND_TLS_CA_CERT
+    client.setCACert(BACKEND_TLS_CA_CERT);
+#else
+    // Encrypted, but the backend certificate is not verified
+    client.setInsecure();
+#endif
+
+    HTTPClient http;
+    http.setConnectTimeout(timeout);
+    http.setTimeout(timeout);
+
+    int statusCode = HTTP_TRANSPORT_ERROR_CONNECT;
+    String body;
+    if (http.begin(client, request.host, request.port, request.path, true))
+    {
+        http.setUserAgent("PalPalette-ESP32");
+        if (request.body.length() > 0 || request.method == "POST" || request.method == "PUT")
+        {
+            http.addHeader("Content-Type", "application/json");
+        }
+
+        // Extra headers arrive as raw "Name: value\r\n" lines
+        int lineStart = 0;
+        while (lineStart < (int)request.headers.length())
+        {
+            int lineEnd = request.headers.indexOf("\r\n", lineStart);
+            if (lineEnd < 0)
+            {
+                lineEnd = request.headers.length();
+            }
+            int colon = request.headers.indexOf(':', lineStart);
+            if (colon > lineStart && colon < lineEnd)
+            {
+                String value = request.headers.substring(colon + 1, lineEnd);
+                value.trim();
+                http.addHeader(request.headers.substring(lineStart, colon), value);
+            }
+            lineStart = lineEnd + 2;
+        }
+
+        int result = http.sendRequest(request.method.c_str(), request.body);
+        if (result > 0)
+        {
+            statusCode = result;
+            if (!request.discardBody)
+            {
+                if (http.getSize() > HTTP_TRANSPORT_MAX_RESPONSE)
+                {
+                    statusCode = HTTP_TRANSPORT_ERROR_OVERFLOW;
+                }
+                else
+                {
+                    body = http.getString();
+                }
+            }
+        }
+        else if (result == HTTPC_ERROR_READ_TIMEOUT)
+        {
+            statusCode = HTTP_TRANSPORT_ERROR_TIMEOUT;
+        }
+        else if (result != HTTPC_ERROR_CONNECTION_REFUSED)
+        {
+            statusCode = HTTP_TRANSPORT_ERROR_CLOSED;
+        }
+        http.end();
+    }
+
+    lock();
+    // The slot may have timed out and been handed to another request meanwhile
+    if (job.slot->id == job.id && job.slot->state == SLOT_ACTIVE)
+    {
+        job.slot->response.body = body;
+        finishSlot(*job.slot, statusCode);
+    }
+    unlock();
+}
+
+void HttpTransport::pumpWrite(Slot &slot)
+{
+    if (!slot.client || slot.txOffset >= slot.tx.length())
+    {
+        return;
+    }
+
+    size_t space = slot.client->space();
+    size_t remaining = slot.tx.length() - slot.txOffset;
+    size_t chunk = min(space, remaining);
+    if (chunk == 0)
+    {
+        return;
+    }
+
+    size_t written = slot.client->add(slot.tx.c_str() + slot.txOffset, chunk);
+    if (written > 0)
+    {
+        slot.txOffset += written;
+        slot.client->send();
+    }
+
+    if (slot.txOffset >= slot.tx.length())
+    {
+        slot.tx = String(); // Free the request buffer once it is on the wire
+        slot.txOffset = 0;
+    }
+}
+
+void HttpTransport::parseResponse(Slot &slot)
+{
+    if (slot.statusCode == 0)
+    {
+        int lineEnd = slot.rx.indexOf("\r\n");
+        if (lineEnd < 0)
+        {
+            return;
+        }
+
+        // "HTTP/1.1 200 OK"
+        int space = slot.rx.indexOf(' ');
+        if (space < 0 || space > lineEnd)
+        {
+            finishSlot(slot, HTTP_TRANSPORT_ERROR_INVALID);
+            return;
+        }
+        slot.statusCode = slot.rx.substring(space + 1, space + 4).toInt();
+
+        if (slot.request.discardBody)
+        {
+            finishSlot(slot, slot.statusCode);
+            return;
+        }
+    }
+
+    if (slot.headerEnd < 0)
+    {
+        int end = slot.rx.indexOf("\r\n\r\n");
+        if (end < 0)
+        {
+            return;
+        }
+        slot.headerEnd = end + 4;
+
+        String headers = slot.rx.substring(0, end);
+        headers.toLowerCase();
+
+        int lengthIndex = headers.indexOf("\r\ncontent-length:");
+        if (lengthIndex >= 0)
+        {
+            slot.contentLength = headers.substring(lengthIndex + 17).toInt();
+        }
+        slot.chunked = headers.indexOf("\r\ntransfer-encoding: chunked") >= 0;
+    }
+
+    if (slot.contentLength >= 0 && (long)(slot.rx.length() - slot.headerEnd) >= slot.contentLength)
+    {
+        finishSlot(slot, slot.statusCode);
+    }
+}
+
+void HttpTransport::finishSlot(Slot &slot, int statusCode)
+{
+    if (slot.state == SLOT_DONE || slot.state == SLOT_FREE)
+    {
+        return;
+    }
+
+    slot.response.statusCode = statusCode;
+    slot.response.latencyMs = millis() - slot.startedAt;
+
+    if (statusCode > 0 && !slot.request.discardBody && slot.headerEnd >= 0)
+    {
+        String body = slot.rx.substring(slot.headerEnd);
+        slot.response.body = slot.chunked ? decodeChunked(body) : body;
+    }
+
+    slot.rx = String();
+    slot.state = SLOT_DONE;
+}
+
+String HttpTransport::decodeChunked(const String &raw)
+{
+    String body;
+    int pos = 0;
+
+    while (pos < (int)raw.length())
+    {
+        int lineEnd = raw.indexOf("\r\n", pos);
+        if (lineEnd < 0)
+        {
+            break;
+        }
+
+        long size = strtol(raw.substring(pos, lineEnd).c_str(), NULL, 16);
+        if (size <= 0)
+        {
+            break;
+        }
+
+        body += raw.substring(lineEnd + 2, lineEnd + 2 + size);
+        pos = lineEnd + 2 + size + 2;
+    }
+
+    return body;
+}
+
+void HttpTransport::onConnect(Slot *slot, AsyncClient *client)
+{
+    lock();
+    if (slot->client == client && slot->state == SLOT_CONNECTING)
+    {
+        slot->state = SLOT_ACTIVE;
+        pumpWrite(*slot);
+    }
+    unlock();
+}
+
+void HttpTransport::onData(Slot *slot, AsyncClient *client, void *data, size_t len)
+{
+    lock();
+    if (slot->client == client && slot->state == SLOT_ACTIVE)
+    {
+        if (slot->rx.length() + len > HTTP_TRANSPORT_MAX_RESPONSE)
+        {
+            finishSlot(*slot, HTTP_TRANSPORT_ERROR_OVERFLOW);
+        }
+        else if (slot->request.discardBody && slot->statusCode != 0)
+        {
+            // Status already delivered - ignore the rest of the response
+        }
+        else
+        {
+            slot->rx.concat((const char *)data, len);
+            parseResponse(*slot);
+        }
+    }
+    unlock();
+}
+
+void HttpTransport::onAck(Slot *slot, AsyncClient *client)
+{
+    lock();
+    if (slot->client == client && slot->state == SLOT_ACTIVE)
+    {
+        pumpWrite(*slot);
+    }
+    unlock();
+}
+
+void HttpTransport::onError(Slot *slot, AsyncClient *client, int8_t error)
+{
+    lock();
+    if (slot->client == client && (slot->state == SLOT_CONNECTING || slot->state == SLOT_ACTIVE))
+    {
+        finishSlot(*slot, slot->statusCode > 0 ? slot->statusCode : HTTP_TRANSPORT_ERROR_CONNECT);
+    }
+    unlock();
+}
+
+void HttpTransport::onDisconnect(Slot *slot, AsyncClient *client)
+{
+    lock();
+    if (slot->client == client)
+    {
+        // Without Content-Length the server closing the socket ends the body
+        if (slot->state == SLOT_CONNECTING || slot->state == SLOT_ACTIVE)
+        {
+            finishSlot(*slot, slot->headerEnd >= 0 ? slot->statusCode : HTTP_TRANSPORT_ERROR_CLOSED);
+        }
+        slot->client = nullptr;
+    }
+    unlock();
+
+    // Disconnect is the last event AsyncTCP delivers for a client
+    delete client;
+}
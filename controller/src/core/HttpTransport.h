@@ -0,0 +1,175 @@
+#ifndef HTTP_TRANSPORT_H
+#define HTTP_TRANSPORT_H
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <functional>
+#include "../config.h"
+
+// Negative status codes reported when no HTTP status line was received
+#define HTTP_TRANSPORT_ERROR_CONNECT -1
+#define HTTP_TRANSPORT_ERROR_TIMEOUT -2
+#define HTTP_TRANSPORT_ERROR_CLOSED -3
+#define HTTP_TRANSPORT_ERROR_OVERFLOW -4
+#define HTTP_TRANSPORT_ERROR_INVALID -5
+
+/**
+ * Result of a request issued through HttpTransport
+ */
+struct HttpResponse
+{
+    int statusCode;          // HTTP status code, or one of HTTP_TRANSPORT_ERROR_*
+    String body;             // Response body (always empty for discardBody requests)
+    unsigned long latencyMs; // Time from dispatch to completion
+
+    HttpResponse() : statusCode(0), latencyMs(0) {}
+
+    bool ok() const { return statusCode >= 200 && statusCode < 300; }
+};
+
+typedef std::function<void(const HttpResponse &)> HttpCallback;
+
+/**
+ * A single HTTP/1.1 request. The transport always sends "Connection: close",
+ * so the end of the body is either Content-Length or the server closing.
+ */
+struct HttpRequest
+{
+    String host;
+    uint16_t port;
+    String method;
+    String path;
+    String body;
+    String headers;          // Extra header lines, each terminated with "\r\n"
+    unsigned long timeoutMs; // 0 = HTTP_TRANSPORT_DEFAULT_TIMEOUT
+    bool discardBody;        // Complete as soon as the status line arrives
+    bool secure;             // https://, only set by setUrl(); light controllers always use plain HTTP
+    HttpCallback callback;   // Invoked from HttpTransport::loop()
+
+    HttpRequest() : port(80), method("GET"), path("/"), timeoutMs(0), discardBody(false), secure(false) {}
+
+    /**
+     * Fill host, port, path and secure from an http:// or https:// URL
+     * @return false for malformed URLs or other schemes
+     */
+    bool setUrl(const String &url);
+};
+
+/**
+ * Non-blocking HTTP client shared by the light controllers and DeviceManager
+ *
+ * Requests are queued and dispatched on AsyncTCP connections. Every host gets
+ * at most HTTP_TRANSPORT_SLOTS_PER_HOST concurrent connections, so a slow light
+ * never occupies the slots another target needs. Network events arrive on the
+ * AsyncTCP task; completion callbacks are always invoked from loop(), on the
+ * task that sent the request, so each caller keeps its state single-threaded.
+ *
+ * AsyncTCP has no TLS, so secure requests (the backend behind https://) run
+ * on a short-lived worker task with HTTPClient and WiFiClientSecure. They
+ * take a slot like any other request and complete through loop() as well.
+ */
+class HttpTransport
+{
+public:
+    HttpTransport();
+    ~HttpTransport();
+
+    /**
+     * Queue a request
+     * @return request id, or 0 if the queue is full or the request is invalid
+     */
+    uint32_t send(const HttpRequest &request);
+
+    /**
+     * Queue a request and wait for it to complete, servicing the transport
+     * while waiting. Intended for cold paths (setup, discovery, status reads).
+     */
+    HttpResponse execute(HttpRequest request);
+
+    /**
+     * Start queued requests, enforce timeouts and deliver the completions
+     * of requests sent from the calling task
+     */
+    void loop();
+
+    /**
+     * Number of requests that are queued or in flight
+     */
+    int pendingCount();
+
+private:
+    enum SlotState
+    {
+        SLOT_FREE,
+        SLOT_CONNECTING,
+        SLOT_ACTIVE,
+        SLOT_DONE
+    };
+
+    struct Slot
+    {
+        SlotState state;
+        AsyncClient *client;
+        HttpRequest request;
+        uint32_t id;
+        TaskHandle_t owner; // Task whose loop() delivers the callback
+        unsigned long startedAt;
+        String tx;
+        size_t txOffset;
+        String rx;
+        int statusCode;
+        int headerEnd;     // Offset of the body in rx, -1 while headers are incomplete
+        long contentLength; // -1 when the server did not send one
+        bool chunked;
+        HttpResponse response;
+    };
+
+    // Handed to the TLS worker task; the request is a copy so a timed-out
+    // slot can be reused while the worker is still finishing
+    struct SecureJob
+    {
+        HttpTransport *transport;
+        Slot *slot;
+        uint32_t id;
+        HttpRequest request;
+    };
+
+    struct QueuedRequest
+    {
+        HttpRequest request;
+        uint32_t id;
+        TaskHandle_t owner;
+    };
+
+    Slot slots[HTTP_TRANSPORT_MAX_SLOTS];
+    QueuedRequest queue[HTTP_TRANSPORT_QUEUE_SIZE];
+    int queueHead;
+    int queueCount;
+    uint32_t nextId;
+    SemaphoreHandle_t mutex;
+
+    void lock();
+    void unlock();
+
+    void startQueued();
+    bool startSlot(Slot &slot, const QueuedRequest &queued);
+    bool startSecure(Slot &slot);
+    static void secureTaskEntry(void *param);
+    void runSecure(SecureJob &job);
+    int activeForHost(const String &host, uint16_t port);
+    void pumpWrite(Slot &slot);
+    void parseResponse(Slot &slot);
+    void finishSlot(Slot &slot, int statusCode);
+    static String decodeChunked(const String &raw);
+
+    // AsyncTCP event handlers (run on the AsyncTCP task)
+    void onConnect(Slot *slot, AsyncClient *client);
+    void onData(Slot *slot, AsyncClient *client, void *data, size_t len);
+    void onAck(Slot *slot, AsyncClient *client);
+    void onError(Slot *slot, AsyncClient *client, int8_t error);
+    void onDisconnect(Slot *slot, AsyncClient *client);
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "JobManager.h"
+
+void Job::setProgress(int percent, const String &stageName)
+{
+    if (isFinished())
+    {
+        return;
+    }
+
+    progress = constrain(percent, 0, 100);
+    stage = stageName;
+    changed = true;
+}
+
+void Job::succeed()
+{
+    state = JOB_SUCCEEDED;
+    progress = 100;
+    stage = "done";
+    changed = true;
+}
+
+void Job::fail(const String &reason)
+{
+    state = JOB_FAILED;
+    stage = "failed";
+    error = reason;
+    changed = true;
+}
+
+JobManager::JobManager() : nextId(1)
+{
+}
+
+Job *JobManager::allocate(const char *type, const String &requestId)
+{
+    for (int i = 0; i < MAX_JOBS; i++)
+    {
+        if (jobs[i].state == JOB_FREE)
+        {
+            Job &job = jobs[i];
+            job = Job();
+            job.id = nextId++;
+            job.type = type;
+            job.requestId = requestId;
+            job.state = JOB_RUNNING;
+            job.stage = "queued";
+            job.startedAt = millis();
+            job.changed = true;
+            return &job;
+        }
+    }
+
+    Serial.println("⚠ No free job slot for " + String(type));
+    return nullptr;
+}
+
+uint32_t JobManager::start(const char *type, const String &requestId, JobStep step)
+{
+    Job *job = allocate(type, requestId);
+    if (!job)
+    {
+        return 0;
+    }
+
+    job->step = step;
+    return job->id;
+}
+
+uint32_t JobManager::track(const char *type, const String &requestId, uint32_t commandId)
+{
+    if (commandId == 0)
+    {
+        return 0;
+    }
+
+    Job *job = allocate(type, requestId);
+    if (!job)
+    {
+        return 0;
+    }
+
+    job->commandId = commandId;
+    return job->id;
+}
+
+Job *JobManager::findByCommand(uint32_t commandId)
+{
+    for (int i = 0; i < MAX_JOBS; i++)
+    {
+        if (jobs[i].state == JOB_RUNNING && jobs[i].commandId == commandId && commandId != 0)
+        {
+            return &jobs[i];
+        }
+    }
+    return nullptr;
+}
+
+void JobManager::loop()
+{
+    for (int i = 0; i < MAX_JOBS; i++)
+    {
+        Job &job = jobs[i];
+        if (job.state == JOB_FREE)
+        {
+            continue;
+        }
+
+        if (job.state == JOB_RUNNING && job.step)
+        {
+            job.step(job);
+        }
+
+        if (job.state == JOB_RUNNING && millis() - job.startedAt > JOB_TIMEOUT)
+        {
+            job.fail("timed out");
+        }
+
+        if (job.changed)
+        {
+            job.changed = false;
+            if (listener)
+            {
+                listener(job);
+            }
+        }
+
+        if (job.isFinished())
+        {
+            job = Job();
+        }
+    }
+}
+
+int JobManager::activeCount() const
+{
+    int count = 0;
+    for (int i = 0; i < MAX_JOBS; i++)
+    {
+        if (jobs[i].state == JOB_RUNNING)
+        {
+            count++;
+        }
+    }
+    return count;
+}
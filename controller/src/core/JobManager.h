@@ -0,0 +1,94 @@
+#ifndef JOB_MANAGER_H
+#define JOB_MANAGER_H
+
+#include <Arduino.h>
+#include <functional>
+#include "../config.h"
+
+enum JobState
+{
+    JOB_FREE,
+    JOB_RUNNING,
+    JOB_SUCCEEDED,
+    JOB_FAILED
+};
+
+struct Job;
+
+// Advances a main-loop job by one small step; must not block
+typedef std::function<void(Job &job)> JobStep;
+
+/**
+ * A long-running operation started by a WebSocket command
+ */
+struct Job
+{
+    uint32_t id;
+    const char *type;        // e.g. "lightingConfig", reported to the backend
+    String requestId;        // Backend reference echoed in every report, may be empty
+    JobState state;
+    int progress;            // 0-100
+    String stage;
+    String error;
+    unsigned long startedAt;
+    uint32_t commandId;      // Lighting task command doing the work, 0 for main-loop jobs
+    JobStep step;
+    bool changed;            // Progress or state not reported yet
+
+    Job() : id(0), type(""), state(JOB_FREE), progress(0), startedAt(0), commandId(0), changed(false) {}
+
+    void setProgress(int percent, const String &stageName);
+    void succeed();
+    void fail(const String &reason);
+    bool isFinished() const { return state == JOB_SUCCEEDED || state == JOB_FAILED; }
+};
+
+typedef std::function<void(const Job &job)> JobListener;
+
+/**
+ * Tracks long-running operations so their progress can be reported
+ *
+ * Two kinds of jobs exist:
+ *   - main-loop jobs advance through their step function, called from loop()
+ *   - lighting jobs run as a LightingTask command; the WebSocket client
+ *     forwards the task's progress and completion events to them
+ * loop() hands every change to the listener (which turns it into a
+ * jobProgress or jobCompleted event) and frees finished jobs afterwards.
+ * Jobs that run longer than JOB_TIMEOUT fail.
+ *
+ * Not thread-safe: only the WebSocket loop uses it.
+ */
+class JobManager
+{
+public:
+    JobManager();
+
+    void setListener(JobListener jobListener) { listener = jobListener; }
+
+    /**
+     * Start a job advanced by step() from loop()
+     * @return job id, or 0 when MAX_JOBS are already running
+     */
+    uint32_t start(const char *type, const String &requestId, JobStep step);
+
+    /**
+     * Track a job carried out by a lighting task command
+     * @return job id, or 0 when MAX_JOBS are already running
+     */
+    uint32_t track(const char *type, const String &requestId, uint32_t commandId);
+
+    Job *findByCommand(uint32_t commandId);
+
+    void loop();
+
+    int activeCount() const;
+
+private:
+    Job jobs[MAX_JOBS];
+    uint32_t nextId;
+    JobListener listener;
+
+    Job *allocate(const char *type, const String &requestId);
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "JsonArena.h"
+
+JsonArena::JsonArena() : offset(0), lastBlock(nullptr), peakUsage(0), fallbackCount(0)
+{
+}
+
+bool JsonArena::owns(const void *ptr) const
+{
+    const uint8_t *p = static_cast<const uint8_t *>(ptr);
+    return p >= buffer && p < buffer + sizeof(buffer);
+}
+
+void *JsonArena::allocate(size_t size)
+{
+    size_t total = ALIGNMENT + align(size);
+    if (offset + total > sizeof(buffer))
+    {
+        fallbackCount++;
+        return malloc(size);
+    }
+
+    uint8_t *block = buffer + offset + ALIGNMENT;
+    blockSize(block) = size;
+    lastBlock = block;
+
+    offset += total;
+    if (offset > peakUsage)
+    {
+        peakUsage = offset;
+    }
+
+    return block;
+}
+
+void JsonArena::deallocate(void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    if (!owns(ptr))
+    {
+        free(ptr);
+        return;
+    }
+
+    // Only the newest block can be handed back early; everything else is
+    // reclaimed by reset()
+    if (ptr == lastBlock)
+    {
+        offset = lastBlock - buffer - ALIGNMENT;
+        lastBlock = nullptr;
+    }
+}
+
+void *JsonArena::reallocate(void *ptr, size_t newSize)
+{
+    if (!ptr)
+    {
+        return allocate(newSize);
+    }
+
+    if (!owns(ptr))
+    {
+        return realloc(ptr, newSize);
+    }
+
+    size_t oldSize = blockSize(ptr);
+
+    if (ptr == lastBlock)
+    {
+        // Grow or shrink the newest block in place
+        size_t start = lastBlock - buffer;
+        if (start + align(newSize) <= sizeof(buffer))
+        {
+            blockSize(ptr) = newSize;
+            offset = start + align(newSize);
+            if (offset > peakUsage)
+            {
+                peakUsage = offset;
+            }
+            return ptr;
+        }
+    }
+    else if (newSize <= oldSize)
+    {
+        blockSize(ptr) = newSize;
+        return ptr;
+    }
+
+    void *moved = allocate(newSize);
+    if (moved)
+    {
+        memcpy(moved, ptr, min(oldSize, newSize));
+        deallocate(ptr);
+    }
+    return moved;
+}
+
+void JsonArena::reset()
+{
+    offset = 0;
+    lastBlock = nullptr;
+}
@@ -0,0 +1,52 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+
+/**
+ * Fixed-size bump allocator for ArduinoJson documents
+ *
+ * Inbound WebSocket messages are parsed into a JsonDocument backed by this
+ * arena instead of the heap. Memory is handed out linearly from a static
+ * buffer and released all at once with reset() before the next message, so
+ * parsing does not fragment the heap. Requests that do not fit fall back to
+ * malloc() and are counted, which makes an undersized arena visible.
+ *
+ * Not thread-safe: use one arena per task.
+ */
+class JsonArena : public ArduinoJson::Allocator
+{
+public:
+    JsonArena();
+
+    void *allocate(size_t size) override;
+    void deallocate(void *ptr) override;
+    void *reallocate(void *ptr, size_t newSize) override;
+
+    /**
+     * Release every arena block. Documents using the arena must be cleared
+     * or destroyed first.
+     */
+    void reset();
+
+    size_t used() const { return offset; }
+    size_t peak() const { return peakUsage; }
+    uint32_t getFallbackCount() const { return fallbackCount; }
+
+private:
+    static const size_t ALIGNMENT = 8; // Also the size of the block header
+
+    alignas(8) uint8_t buffer[WS_JSON_ARENA_SIZE];
+    size_t offset;
+    uint8_t *lastBlock; // Most recent arena block, the only one that can grow in place
+    size_t peakUsage;
+    uint32_t fallbackCount;
+
+    bool owns(const void *ptr) const;
+    static size_t align(size_t size) { return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+    static size_t &blockSize(void *ptr) { return *reinterpret_cast<size_t *>(static_cast<uint8_t *>(ptr) - ALIGNMENT); }
+};
+
+#endif
@@ -0,0 +1,215 @@
+#include "LoopScheduler.h"
+
+void LoopStats::record(uint32_t durationMicros)
+{
+    count++;
+    totalMicros += durationMicros;
+    maxMicros = max(maxMicros, durationMicros);
+    if (durationMicros > LOOP_SLOW_THRESHOLD * 1000UL)
+    {
+        slow++;
+    }
+
+    int bucket = 0;
+    while (bucket < LOOP_HISTOGRAM_BUCKETS - 1 && durationMicros > loopHistogramBounds[bucket] * 1000UL)
+    {
+        bucket++;
+    }
+    histogram[bucket]++;
+}
+
+void LoopStats::report(JsonObject out, bool withHistogram) const
+{
+    out["runs"] = count;
+    out["slow"] = slow;
+    out["avgUs"] = count > 0 ? (uint32_t)(totalMicros / count) : 0;
+    out["maxMs"] = (maxMicros + 999) / 1000;
+    if (withHistogram)
+    {
+        JsonArray buckets = out["histogram"].to<JsonArray>();
+        for (int i = 0; i < LOOP_HISTOGRAM_BUCKETS; i++)
+        {
+            buckets.add(histogram[i]);
+        }
+    }
+}
+
+LoopScheduler::LoopScheduler() : taskCount(0), sleptMs(0), startedAt(0)
+{
+    context[0] = '\0';
+    lastSlowPass.at = 0;
+    lastSlowPass.micros = 0;
+    lastSlowPass.task = -1;
+    lastSlowPass.context[0] = '\0';
+}
+
+int LoopScheduler::add(const char *name, unsigned long periodMs, LoopTaskFunction function)
+{
+    if (taskCount >= LOOP_SCHEDULER_MAX_TASKS)
+    {
+        Serial.println("⚠ No free scheduler slot for " + String(name));
+        return -1;
+    }
+
+    Task &task = tasks[taskCount];
+    task.name = name;
+    task.periodMs = periodMs;
+    task.dueAt = millis();
+    task.function = function;
+    task.stats = LoopStats();
+
+    if (taskCount == 0)
+    {
+        startedAt = task.dueAt;
+    }
+    return taskCount++;
+}
+
+void LoopScheduler::setContext(const char *name)
+{
+    strlcpy(context, name, sizeof(context));
+}
+
+void LoopScheduler::runOnce()
+{
+    // Tasks may change the context; a slow pass is blamed on the one it started in
+    char passContext[LOOP_CONTEXT_LENGTH];
+    strlcpy(passContext, context, sizeof(passContext));
+
+    uint32_t passStart = micros();
+    int slowestTask = -1;
+    uint32_t slowestMicros = 0;
+
+    for (int i = 0; i < taskCount; i++)
+    {
+        Task &task = tasks[i];
+        unsigned long now = millis();
+        if (!isDue(task, now))
+        {
+            continue;
+        }
+
+        uint32_t taskStart = micros();
+        task.function();
+        uint32_t taskMicros = micros() - taskStart;
+        task.stats.record(taskMicros);
+        if (slowestTask < 0 || taskMicros > slowestMicros)
+        {
+            slowestTask = i;
+            slowestMicros = taskMicros;
+        }
+
+        // Keep the cadence, but do not replay periods missed while blocked
+        now = millis();
+        task.dueAt += task.periodMs;
+        if (isDue(task, now))
+        {
+            task.dueAt = now + task.periodMs;
+        }
+    }
+
+    if (slowestTask >= 0)
+    {
+        uint32_t passMicros = micros() - passStart;
+        passStats.record(passMicros);
+
+        if (passMicros > LOOP_SLOW_THRESHOLD * 1000UL)
+        {
+            lastSlowPass.at = millis();
+            lastSlowPass.micros = passMicros;
+            lastSlowPass.task = slowestTask;
+            strlcpy(lastSlowPass.context, passContext, sizeof(lastSlowPass.context));
+            Serial.printf("🐢 Loop blocked for %lu ms in %s (%s: %lu ms)\n", (unsigned long)(passMicros / 1000),
+                          passContext, tasks[slowestTask].name, (unsigned long)(slowestMicros / 1000));
+        }
+    }
+
+    unsigned long sleepMs = msUntilNextDue();
+    if (sleepMs > 0)
+    {
+        // delay() is vTaskDelay here: the lighting, WiFi and TCP tasks run meanwhile
+        delay(sleepMs);
+        sleptMs += sleepMs;
+    }
+    else
+    {
+        yield();
+    }
+}
+
+unsigned long LoopScheduler::msUntilNextDue() const
+{
+    unsigned long now = millis();
+    unsigned long next = LOOP_SCHEDULER_MAX_SLEEP;
+    for (int i = 0; i < taskCount; i++)
+    {
+        if (isDue(tasks[i], now))
+        {
+            return 0;
+        }
+        next = min(next, tasks[i].dueAt - now);
+    }
+    return next;
+}
+
+void LoopScheduler::report(JsonObject out) const
+{
+    passStats.report(out, true);
+
+    JsonObject taskStats = out["tasks"].to<JsonObject>();
+    for (int i = 0; i < taskCount; i++)
+    {
+        tasks[i].stats.report(taskStats[tasks[i].name].to<JsonObject>(), false);
+    }
+
+    if (lastSlowPass.task >= 0)
+    {
+        JsonObject slowPass = out["lastSlow"].to<JsonObject>();
+        slowPass["at"] = lastSlowPass.at; // millis(), stable across delta reports
+        slowPass["ms"] = lastSlowPass.micros / 1000;
+        slowPass["task"] = tasks[lastSlowPass.task].name;
+        slowPass["context"] = lastSlowPass.context;
+    }
+}
+
+void LoopScheduler::print() const
+{
+    unsigned long elapsed = millis() - startedAt;
+    Serial.println("🗓 Loop scheduler:");
+    Serial.printf("  %-12s %8s %6s %8s %8s\n", "task", "runs", "slow", "avg us", "max ms");
+    for (int i = 0; i < taskCount; i++)
+    {
+        const LoopStats &stats = tasks[i].stats;
+        Serial.printf("  %-12s %8lu %6lu %8lu %8lu  (every %lu ms)\n", tasks[i].name, (unsigned long)stats.count,
+                      (unsigned long)stats.slow, stats.count > 0 ? (unsigned long)(stats.totalMicros / stats.count) : 0UL,
+                      (unsigned long)((stats.maxMicros + 999) / 1000), tasks[i].periodMs);
+    }
+    Serial.printf("  %-12s %8lu %6lu %8lu %8lu\n", "(pass)", (unsigned long)passStats.count,
+                  (unsigned long)passStats.slow,
+                  passStats.count > 0 ? (unsigned long)(passStats.totalMicros / passStats.count) : 0UL,
+                  (unsigned long)((passStats.maxMicros + 999) / 1000));
+
+    Serial.print("  Pass histogram (ms):");
+    for (int i = 0; i < LOOP_HISTOGRAM_BUCKETS; i++)
+    {
+        if (i < LOOP_HISTOGRAM_BUCKETS - 1)
+        {
+            Serial.printf(" <=%lu:%lu", (unsigned long)loopHistogramBounds[i], (unsigned long)passStats.histogram[i]);
+        }
+        else
+        {
+            Serial.printf(" >%lu:%lu", (unsigned long)loopHistogramBounds[i - 1], (unsigned long)passStats.histogram[i]);
+        }
+    }
+    Serial.println();
+
+    if (lastSlowPass.task >= 0)
+    {
+        Serial.printf("  Last slow pass: %lu ms in %s (%s), %lu s ago\n", (unsigned long)(lastSlowPass.micros / 1000),
+                      lastSlowPass.context, tasks[lastSlowPass.task].name, (millis() - lastSlowPass.at) / 1000);
+    }
+    if (elapsed > 0)
+    {
+        Serial.printf("  Idle: %lu%% of %lu s\n", (unsigned long)(100ULL * sleptMs / elapsed), elapsed / 1000);
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef LOOP_SCHEDULER_H
+#define LOOP_SCHEDULER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include "../config.h"
+
+typedef std::function<void()> LoopTaskFunction;
+
+static const uint32_t loopHistogramBounds[] = {LOOP_HISTOGRAM_BOUNDS};
+static const int LOOP_HISTOGRAM_BUCKETS = sizeof(loopHistogramBounds) / sizeof(loopHistogramBounds[0]) + 1;
+
+/**
+ * Run-time distribution of a loop pass or a single task since boot
+ */
+struct LoopStats
+{
+    uint32_t count;
+    uint32_t slow;        // Runs longer than LOOP_SLOW_THRESHOLD
+    uint64_t totalMicros;
+    uint32_t maxMicros;
+    uint32_t histogram[LOOP_HISTOGRAM_BUCKETS]; // Last bucket holds everything above the highest bound
+
+    LoopStats() : count(0), slow(0), totalMicros(0), maxMicros(0), histogram() {}
+
+    void record(uint32_t durationMicros);
+
+    /**
+     * Add runs, slow, avgUs and maxMs, plus the histogram if requested
+     */
+    void report(JsonObject out, bool withHistogram) const;
+};
+
+/**
+ * Cooperative scheduler for the Arduino loop task
+ *
+ * Every task declares the period it wants to run at. runOnce() runs the
+ * tasks that are due, in the order they were added, and then sleeps until
+ * the earliest next deadline instead of a fixed delay. A task that falls
+ * behind runs once and resumes its period from now rather than catching up
+ * in a burst. Tasks must not block; anything slow belongs on its own
+ * FreeRTOS task (see LightingTask).
+ *
+ * Since everything on the loop shares one thread, every pass and every
+ * task is timed. A pass longer than LOOP_SLOW_THRESHOLD is logged with the
+ * task that took longest and the context (device state) it ran in, so
+ * blocking calls can be found in the field. The numbers go out in
+ * deviceStatus under "loop" and are printed by the "status" and "tasks"
+ * serial commands.
+ */
+class LoopScheduler
+{
+public:
+    LoopScheduler();
+
+    /**
+     * Register a task, first run on the next pass
+     * @return task index, or -1 when LOOP_SCHEDULER_MAX_TASKS are registered
+     */
+    int add(const char *name, unsigned long periodMs, LoopTaskFunction function);
+
+    /**
+     * Run every due task, then sleep until the next one is due
+     */
+    void runOnce();
+
+    /**
+     * Time until the earliest task is due, 0 when one is already due
+     */
+    unsigned long msUntilNextDue() const;
+
+    /**
+     * Name recorded with slow passes, e.g. the device state
+     */
+    void setContext(const char *name);
+
+    void report(JsonObject out) const;
+    void print() const;
+
+private:
+    struct Task
+    {
+        const char *name;
+        unsigned long periodMs;
+        unsigned long dueAt; // millis()
+        LoopTaskFunction function;
+        LoopStats stats;
+    };
+
+    struct SlowPass
+    {
+        unsigned long at; // millis() when the pass finished
+        uint32_t micros;
+        int task;         // Slowest task of the pass
+        char context[LOOP_CONTEXT_LENGTH];
+    };
+
+    Task tasks[LOOP_SCHEDULER_MAX_TASKS];
+    int taskCount;
+    unsigned long sleptMs; // Total time spent sleeping in runOnce()
+    unsigned long startedAt;
+
+    char context[LOOP_CONTEXT_LENGTH];
+    LoopStats passStats;   // Passes that ran at least one task
+    SlowPass lastSlowPass; // task is -1 until the first slow pass
+
+    static bool isDue(const Task &task, unsigned long now) { return (long)(now - task.dueAt) >= 0; }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "OutboundBatch.h"
+
+OutboundBatch::OutboundBatch() : offset(1), count(0)
+{
+    buffer[0] = '[';
+}
+
+char *OutboundBatch::reserve(size_t length)
+{
+    // Room for a separating comma, the closing bracket and a terminator
+    size_t separator = count > 0 ? 1 : 0;
+    if (offset + separator + length + 2 > sizeof(buffer))
+    {
+        return nullptr;
+    }
+
+    if (separator)
+    {
+        buffer[offset++] = ',';
+    }
+
+    char *start = buffer + offset;
+    offset += length;
+    count++;
+    return start;
+}
+
+bool OutboundBatch::add(const JsonDocument &doc)
+{
+    size_t length = measureJson(doc);
+    char *start = reserve(length);
+    if (!start)
+    {
+        return false;
+    }
+
+    serializeJson(doc, start, length + 1);
+    return true;
+}
+
+bool OutboundBatch::add(const char *json, size_t length)
+{
+    char *start = reserve(length);
+    if (!start)
+    {
+        return false;
+    }
+
+    memcpy(start, json, length);
+    return true;
+}
+
+const char *OutboundBatch::frame()
+{
+    if (count > 1)
+    {
+        buffer[offset] = ']';
+        buffer[offset + 1] = '\0';
+        return buffer;
+    }
+
+    buffer[offset] = '\0';
+    return buffer + 1;
+}
+
+size_t OutboundBatch::frameLength() const
+{
+    return count > 1 ? offset + 1 : offset - 1;
+}
+
+void OutboundBatch::clear()
+{
+    offset = 1;
+    count = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef OUTBOUND_BATCH_H
+#define OUTBOUND_BATCH_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+
+/**
+ * Outbound WebSocket messages coalesced into one frame
+ *
+ * Messages are serialized straight into a fixed buffer, separated by commas.
+ * A batch holding a single message is sent as that message; several are sent
+ * as a JSON array envelope ([msg,msg,...]). The first byte of the buffer is
+ * reserved for the opening bracket so the envelope never needs a copy.
+ *
+ * Not thread-safe: only the WebSocket loop uses it.
+ */
+class OutboundBatch
+{
+public:
+    OutboundBatch();
+
+    /**
+     * Append a message
+     * @return false if it does not fit in the remaining space
+     */
+    bool add(const JsonDocument &doc);
+    bool add(const char *json, size_t length);
+
+    /**
+     * Frame for everything added so far; valid until the next add() or clear()
+     */
+    const char *frame();
+    size_t frameLength() const;
+
+    void clear();
+
+    bool isEmpty() const { return count == 0; }
+    int messageCount() const { return count; }
+    size_t used() const { return offset; }
+    size_t capacity() const { return sizeof(buffer); }
+
+private:
+    char buffer[WS_OUTBOUND_BUFFER_SIZE];
+    size_t offset; // End of the last message; messages start at buffer + 1
+    int count;
+
+    char *reserve(size_t length);
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "PaletteFrame.h"
+
+bool PaletteFrame::readText(const uint8_t *data, size_t length, size_t &offset, char *out, size_t outSize)
+{
+    if (offset >= length)
+    {
+        return false;
+    }
+
+    size_t textLength = data[offset++];
+    if (offset + textLength > length)
+    {
+        return false;
+    }
+
+    size_t copied = min(textLength, outSize - 1);
+    memcpy(out, data + offset, copied);
+    out[copied] = '\0';
+    offset += textLength;
+    return true;
+}
+
+uint64_t PaletteFrame::readUint64(const uint8_t *data)
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--)
+    {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+bool PaletteFrame::decode(const uint8_t *data, size_t length, ColorPalette &palette, uint64_t &timestamp, uint64_t &sentAt)
+{
+    if (length < PALETTE_FRAME_HEADER_SIZE || data[0] != PALETTE_FRAME_MAGIC || data[1] != PALETTE_FRAME_TYPE_PALETTE)
+    {
+        return false;
+    }
+
+    uint8_t flags = data[2];
+    uint8_t colorCount = data[3];
+
+    timestamp = readUint64(data + 4);
+    sentAt = 0;
+
+    size_t offset = PALETTE_FRAME_HEADER_SIZE;
+
+    if (flags & PALETTE_FRAME_FLAG_SENT_AT)
+    {
+        if (offset + 8 > length)
+        {
+            return false;
+        }
+        sentAt = readUint64(data + offset);
+        offset += 8;
+    }
+
+    palette = ColorPalette();
+
+    if (flags & PALETTE_FRAME_FLAG_UUID)
+    {
+        if (offset + 16 > length)
+        {
+            return false;
+        }
+
+        // Restore the canonical 8-4-4-4-12 form
+        static const char hex[] = "0123456789abcdef";
+        char *out = palette.messageId;
+        for (int i = 0; i < 16; i++)
+        {
+            if (i == 4 || i == 6 || i == 8 || i == 10)
+            {
+                *out++ = '-';
+            }
+            *out++ = hex[data[offset + i] >> 4];
+            *out++ = hex[data[offset + i] & 0x0F];
+        }
+        *out = '\0';
+        offset += 16;
+    }
+    else if (!readText(data, length, offset, palette.messageId, sizeof(palette.messageId)))
+    {
+        return false;
+    }
+
+    if (!readText(data, length, offset, palette.senderName, sizeof(palette.senderName)))
+    {
+        return false;
+    }
+
+    if (offset + colorCount * 3 != length)
+    {
+        return false;
+    }
+
+    palette.colorCount = min((int)colorCount, MAX_COLORS);
+    for (int i = 0; i < palette.colorCount; i++)
+    {
+        palette.colors[i] = RGBColor(data[offset], data[offset + 1], data[offset + 2]);
+        offset += 3;
+    }
+
+    snprintf(palette.name, sizeof(palette.name), "From %s", palette.senderName);
+    return true;
+}
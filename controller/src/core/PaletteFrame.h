@@ -0,0 +1,41 @@
+#ifndef PALETTE_FRAME_H
+#define PALETTE_FRAME_H
+
+#include <Arduino.h>
+#include "../lighting/LightController.h"
+
+// Binary colorPalette frame, see backend/src/modules/messages/palette-frame.ts
+#define PALETTE_FRAME_FORMAT "binary-v1"
+#define PALETTE_FRAME_MAGIC 0x50
+#define PALETTE_FRAME_TYPE_PALETTE 0x01
+#define PALETTE_FRAME_FLAG_UUID 0x01
+#define PALETTE_FRAME_FLAG_SENT_AT 0x02
+#define PALETTE_FRAME_HEADER_SIZE 12
+
+/**
+ * Fixed-layout palette frame sent by the backend to devices that negotiated
+ * PALETTE_FRAME_FORMAT during registration:
+ *
+ *   magic (1) | type (1) | flags (1) | color count (1) | timestamp ms (8, LE)
+ *   [backend send time ms (8, LE), with PALETTE_FRAME_FLAG_SENT_AT]
+ *   messageId: 16 UUID bytes, or length (1) + text
+ *   senderName: length (1) + text
+ *   color count x RGB (3)
+ */
+class PaletteFrame
+{
+public:
+    /**
+     * Decode a frame straight into a palette without heap allocations
+     * @param timestamp Sender timestamp in ms since epoch
+     * @param sentAt Backend send time in ms since epoch, 0 if absent
+     * @return false for malformed or unknown frames
+     */
+    static bool decode(const uint8_t *data, size_t length, ColorPalette &palette, uint64_t &timestamp, uint64_t &sentAt);
+
+private:
+    static uint64_t readUint64(const uint8_t *data);
+    static bool readText(const uint8_t *data, size_t length, size_t &offset, char *out, size_t outSize);
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "PaletteLatency.h"
+#include <algorithm>
+
+static const uint32_t histogramBounds[] = {LATENCY_HISTOGRAM_BOUNDS};
+static const int histogramBucketCount = sizeof(histogramBounds) / sizeof(histogramBounds[0]) + 1;
+
+LatencyWindow::LatencyWindow() : next(0), filled(0), total(0)
+{
+}
+
+void LatencyWindow::record(uint32_t value)
+{
+    samples[next] = value;
+    next = (next + 1) % LATENCY_WINDOW_SIZE;
+    if (filled < LATENCY_WINDOW_SIZE)
+    {
+        filled++;
+    }
+    total++;
+}
+
+int LatencyWindow::sorted(uint32_t *out) const
+{
+    memcpy(out, samples, filled * sizeof(uint32_t));
+    std::sort(out, out + filled);
+    return filled;
+}
+
+void LatencyWindow::report(JsonObject out) const
+{
+    uint32_t values[LATENCY_WINDOW_SIZE];
+    int n = sorted(values);
+
+    out["count"] = total;
+    if (n == 0)
+    {
+        return;
+    }
+
+    // Nearest-rank percentiles
+    const int percents[] = {50, 90, 99};
+    const char *keys[] = {"p50", "p90", "p99"};
+    for (int i = 0; i < 3; i++)
+    {
+        int rank = (percents[i] * n + 99) / 100;
+        out[keys[i]] = values[constrain(rank, 1, n) - 1];
+    }
+    out["max"] = values[n - 1];
+}
+
+void LatencyWindow::histogram(JsonArray out) const
+{
+    uint32_t counts[histogramBucketCount] = {0};
+    for (int i = 0; i < filled; i++)
+    {
+        int bucket = 0;
+        while (bucket < histogramBucketCount - 1 && samples[i] > histogramBounds[bucket])
+        {
+            bucket++;
+        }
+        counts[bucket]++;
+    }
+
+    for (int i = 0; i < histogramBucketCount; i++)
+    {
+        out.add(counts[i]);
+    }
+}
+
+PaletteLatency::PaletteLatency() : nextPending(0), clockSynced(false), clockOffset(0), clockRtt(0)
+{
+    memset(pending, 0, sizeof(pending));
+}
+
+void PaletteLatency::track(uint32_t commandId, unsigned long receivedAt, uint32_t parseMicros, uint64_t createdAt, uint64_t sentAt)
+{
+    // Oldest entry is overwritten; its palette was replaced in the lighting queue
+    PendingPalette &entry = pending[nextPending];
+    nextPending = (nextPending + 1) % (LIGHTING_COMMAND_QUEUE_SIZE + 1);
+
+    entry.commandId = commandId;
+    entry.receivedAt = receivedAt;
+    entry.parseMicros = parseMicros;
+    entry.createdAt = createdAt;
+    entry.sentAt = sentAt;
+}
+
+void PaletteLatency::complete(uint32_t commandId, const DisplayReport &report)
+{
+    PendingPalette *entry = nullptr;
+    for (int i = 0; i < LIGHTING_COMMAND_QUEUE_SIZE + 1; i++)
+    {
+        if (pending[i].commandId == commandId)
+        {
+            entry = &pending[i];
+            break;
+        }
+    }
+
+    if (!entry || commandId == 0)
+    {
+        return;
+    }
+
+    entry->commandId = 0;
+    if (report.targetCount == 0)
+    {
+        // Nothing was dispatched (lighting not initialized)
+        return;
+    }
+
+    unsigned long acknowledgedAt = report.startedAt + report.latencyMs;
+    uint32_t queueMs = report.startedAt - entry->receivedAt;
+    uint32_t deviceMs = acknowledgedAt - entry->receivedAt;
+
+    parseStage.record(entry->parseMicros);
+    queueStage.record(queueMs);
+    lightsStage.record(report.latencyMs);
+    deviceStage.record(deviceMs);
+
+    if (entry->createdAt && entry->sentAt >= entry->createdAt)
+    {
+        backendStage.record(entry->sentAt - entry->createdAt);
+    }
+
+    int64_t networkMs = -1;
+    int64_t totalMs = -1;
+    if (clockSynced)
+    {
+        // Clamp at zero: the offset is only accurate to half the sync round trip
+        if (entry->sentAt)
+        {
+            networkMs = max((int64_t)0, toServerTime(entry->receivedAt) - (int64_t)entry->sentAt);
+            networkStage.record(networkMs);
+        }
+        if (entry->createdAt)
+        {
+            totalMs = max((int64_t)0, toServerTime(acknowledgedAt) - (int64_t)entry->createdAt);
+            totalStage.record(totalMs);
+        }
+    }
+
+    Serial.printf("⏱ Palette latency: network %ld ms, parse %lu us, queue %lu ms, lights %lu ms, device %lu ms, total %ld ms\n",
+                  (long)networkMs, (unsigned long)entry->parseMicros, (unsigned long)queueMs,
+                  (unsigned long)report.latencyMs, (unsigned long)deviceMs, (long)totalMs);
+}
+
+void PaletteLatency::applyTimeSync(uint32_t requestedAt, uint64_t serverTime)
+{
+    uint32_t now = millis();
+    uint32_t rtt = now - requestedAt;
+
+    if (rtt > TIME_SYNC_MAX_RTT)
+    {
+        Serial.printf("⏱ Ignoring time sync with %lu ms round trip\n", (unsigned long)rtt);
+        return;
+    }
+
+    // Assume the reply was generated halfway through the round trip
+    clockOffset = (int64_t)serverTime + rtt / 2 - (int64_t)now;
+    clockRtt = rtt;
+    clockSynced = true;
+
+    Serial.printf("⏱ Clock synced with backend (round trip %lu ms)\n", (unsigned long)rtt);
+}
+
+void PaletteLatency::report(JsonObject out) const
+{
+    out["clockSynced"] = clockSynced;
+    if (clockSynced)
+    {
+        out["clockRttMs"] = clockRtt;
+    }
+
+    JsonObject stages = out["stages"].to<JsonObject>();
+    backendStage.report(stages["backendMs"].to<JsonObject>());
+    networkStage.report(stages["networkMs"].to<JsonObject>());
+    parseStage.report(stages["parseUs"].to<JsonObject>());
+    queueStage.report(stages["queueMs"].to<JsonObject>());
+    lightsStage.report(stages["lightsMs"].to<JsonObject>());
+    deviceStage.report(stages["deviceMs"].to<JsonObject>());
+    totalStage.report(stages["totalMs"].to<JsonObject>());
+
+    // Histogram of whichever end-to-end measure is available
+    const LatencyWindow &endToEnd = clockSynced && totalStage.count() > 0 ? totalStage : deviceStage;
+    JsonObject histogram = out["histogram"].to<JsonObject>();
+    histogram["stage"] = &endToEnd == &totalStage ? "totalMs" : "deviceMs";
+    JsonArray bounds = histogram["boundsMs"].to<JsonArray>();
+    for (int i = 0; i < histogramBucketCount - 1; i++)
+    {
+        bounds.add(histogramBounds[i]);
+    }
+    endToEnd.histogram(histogram["counts"].to<JsonArray>());
+}
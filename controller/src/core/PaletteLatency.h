@@ -0,0 +1,114 @@
+#ifndef PALETTE_LATENCY_H
+#define PALETTE_LATENCY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../lighting/LightManager.h"
+#include "../config.h"
+
+/**
+ * Rolling window of latency samples with percentile and histogram reporting
+ */
+class LatencyWindow
+{
+public:
+    LatencyWindow();
+
+    void record(uint32_t value);
+    uint32_t count() const { return total; }
+
+    /**
+     * Add count, p50, p90, p99 and max to a JSON object
+     */
+    void report(JsonObject out) const;
+
+    /**
+     * Add bucket counts for LATENCY_HISTOGRAM_BOUNDS to a JSON array;
+     * the last bucket holds everything above the highest bound
+     */
+    void histogram(JsonArray out) const;
+
+private:
+    uint32_t samples[LATENCY_WINDOW_SIZE];
+    int next;
+    int filled;
+    uint32_t total; // Samples recorded since boot
+
+    int sorted(uint32_t *out) const;
+};
+
+/**
+ * End-to-end palette latency tracking
+ *
+ * Every palette is followed from the backend to the lights:
+ *   backend  - palette created -> sent by the backend (server clock)
+ *   network  - sent by the backend -> frame received (needs clock sync)
+ *   parse    - frame received -> palette decoded (microseconds)
+ *   queue    - decoded -> dispatched by the lighting task
+ *   lights   - dispatched -> slowest target acknowledged (HTTP status or show())
+ *   device   - frame received -> lights acknowledged
+ *   total    - palette created -> lights acknowledged (needs clock sync)
+ *
+ * The backend clock offset comes from a timeSync exchange; until the first
+ * sample arrives only the device-local stages are recorded.
+ */
+class PaletteLatency
+{
+public:
+    PaletteLatency();
+
+    /**
+     * Remember a palette that was handed to the lighting task
+     * @param createdAt Backend creation time in ms since epoch, 0 if unknown
+     * @param sentAt Backend send time in ms since epoch, 0 if unknown
+     */
+    void track(uint32_t commandId, unsigned long receivedAt, uint32_t parseMicros, uint64_t createdAt, uint64_t sentAt);
+
+    /**
+     * Record the stages of a palette once the lights acknowledged it
+     */
+    void complete(uint32_t commandId, const DisplayReport &report);
+
+    /**
+     * Apply a timeSync reply
+     * @param requestedAt millis() when the request was sent
+     * @param serverTime Backend time in ms since epoch when it answered
+     */
+    void applyTimeSync(uint32_t requestedAt, uint64_t serverTime);
+
+    bool isClockSynced() const { return clockSynced; }
+
+    /**
+     * Add clock state, per-stage percentiles and the end-to-end histogram
+     */
+    void report(JsonObject out) const;
+
+private:
+    struct PendingPalette
+    {
+        uint32_t commandId; // 0 = free
+        unsigned long receivedAt;
+        uint32_t parseMicros;
+        uint64_t createdAt;
+        uint64_t sentAt;
+    };
+
+    PendingPalette pending[LIGHTING_COMMAND_QUEUE_SIZE + 1];
+    int nextPending;
+
+    bool clockSynced;
+    int64_t clockOffset; // Backend epoch ms minus device millis()
+    uint32_t clockRtt;
+
+    LatencyWindow backendStage;
+    LatencyWindow networkStage;
+    LatencyWindow parseStage;
+    LatencyWindow queueStage;
+    LatencyWindow lightsStage;
+    LatencyWindow deviceStage;
+    LatencyWindow totalStage;
+
+    int64_t toServerTime(unsigned long deviceMillis) const { return (int64_t)deviceMillis + clockOffset; }
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "PingMonitor.h"
+
+PingMonitor::PingMonitor()
+    : sequence(0), awaitingPong(false), sentAt(0), missedPongs(0), srtt(0), rttvar(0), lastRtt(0), maxRtt(0), samples(0),
+      totalMissed(0)
+{
+}
+
+void PingMonitor::connectionOpened()
+{
+    awaitingPong = false;
+    missedPongs = 0;
+}
+
+uint32_t PingMonitor::pingSent()
+{
+    if (awaitingPong)
+    {
+        pongMissed();
+    }
+
+    awaitingPong = true;
+    sentAt = millis();
+    return ++sequence;
+}
+
+void PingMonitor::pongReceived(const String &payload)
+{
+    // Any pong proves the connection is alive, even a late one
+    missedPongs = 0;
+
+    if (!awaitingPong || (uint32_t)payload.toInt() != sequence)
+    {
+        return;
+    }
+
+    awaitingPong = false;
+    unsigned long rtt = millis() - sentAt;
+    lastRtt = rtt;
+    maxRtt = max(maxRtt, rtt);
+
+    if (samples == 0)
+    {
+        srtt = rtt << 3;
+        rttvar = rtt << 1;
+    }
+    else
+    {
+        // srtt += (rtt - srtt) / 8, rttvar += (|rtt - srtt| - rttvar) / 4
+        long delta = (long)rtt - (long)(srtt >> 3);
+        srtt += delta;
+        rttvar += labs(delta) - (rttvar >> 2);
+    }
+    samples++;
+}
+
+bool PingMonitor::pongOverdue() const
+{
+    return awaitingPong && millis() - sentAt > getPongTimeoutMs();
+}
+
+void PingMonitor::pongMissed()
+{
+    awaitingPong = false;
+    missedPongs++;
+    totalMissed++;
+}
+
+unsigned long PingMonitor::getPongTimeoutMs() const
+{
+    if (!hasSample())
+    {
+        return WS_PONG_TIMEOUT_MAX;
+    }
+    return constrain(2 * getRetransmitTimeoutMs(), (unsigned long)WS_PONG_TIMEOUT_MIN, (unsigned long)WS_PONG_TIMEOUT_MAX);
+}
+
+unsigned long PingMonitor::getRequestTimeoutMs() const
+{
+    if (!hasSample())
+    {
+        return 0;
+    }
+    return constrain(BACKEND_HTTP_RTT_FACTOR * getRetransmitTimeoutMs(), (unsigned long)BACKEND_HTTP_TIMEOUT_MIN,
+                     (unsigned long)BACKEND_HTTP_TIMEOUT_MAX);
+}
+
+void PingMonitor::report(JsonObject out) const
+{
+    out["pongs"] = samples;
+    out["missedPongs"] = totalMissed;
+    if (hasSample())
+    {
+        out["rttMs"] = getSmoothedRttMs();
+        out["jitterMs"] = getJitterMs();
+        out["maxRttMs"] = maxRtt;
+    }
+}
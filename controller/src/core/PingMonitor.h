@@ -0,0 +1,83 @@
+#ifndef PING_MONITOR_H
+#define PING_MONITOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+
+/**
+ * Round-trip tracking for WebSocket ping/pong
+ *
+ * Every ping carries a sequence number that the backend echoes in its pong.
+ * Samples feed a smoothed RTT and a smoothed mean deviation (jitter) using
+ * the integer estimator from TCP (RFC 6298), which also yields a
+ * retransmission-style timeout of srtt + 4 * jitter. A pong that does not
+ * arrive within that timeout counts as missed; WS_PING_MAX_MISSED misses in
+ * a row mean the connection is dead even if TCP has not noticed.
+ */
+class PingMonitor
+{
+public:
+    PingMonitor();
+
+    /**
+     * New connection: forget the outstanding ping, keep the RTT estimate
+     */
+    void connectionOpened();
+
+    /**
+     * Record a ping
+     * @return sequence number to send as the ping payload
+     */
+    uint32_t pingSent();
+
+    /**
+     * Record a pong with the payload the backend echoed
+     */
+    void pongReceived(const String &payload);
+
+    /**
+     * Whether the outstanding ping has waited longer than getPongTimeoutMs()
+     */
+    bool pongOverdue() const;
+
+    /**
+     * Give up on the outstanding ping
+     */
+    void pongMissed();
+
+    bool isDead() const { return missedPongs >= WS_PING_MAX_MISSED; }
+    int getMissedPongs() const { return missedPongs; }
+
+    bool hasSample() const { return samples > 0; }
+    unsigned long getLastRttMs() const { return lastRtt; }
+    unsigned long getSmoothedRttMs() const { return srtt >> 3; }
+    unsigned long getJitterMs() const { return rttvar >> 2; }
+    unsigned long getPongTimeoutMs() const;
+
+    /**
+     * Timeout for HTTP requests to the backend scaled from the measured RTT,
+     * or 0 (transport default) until there is a sample
+     */
+    unsigned long getRequestTimeoutMs() const;
+
+    void report(JsonObject out) const;
+
+private:
+    uint32_t sequence;
+    bool awaitingPong;
+    unsigned long sentAt;
+    int missedPongs;
+
+    // Scaled like the TCP estimator: srtt by 8, rttvar by 4
+    unsigned long srtt;
+    unsigned long rttvar;
+    unsigned long lastRtt;
+    unsigned long maxRtt;
+    uint32_t samples;
+    uint32_t totalMissed;
+
+    unsigned long getRetransmitTimeoutMs() const { return (srtt >> 3) + rttvar; }
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "ReconnectBackoff.h"
+
+ReconnectBackoff::ReconnectBackoff()
+    : isConnected(false), consecutiveFailures(0), scheduledAt(0), retryDelayMs(0), connectedAt(0),
+      disconnectedAt(millis()), attempts(0), successes(0), disconnects(0), totalDisconnectedMs(0), lastFailureAt(0)
+{
+    lastFailure[0] = '\0';
+}
+
+bool ReconnectBackoff::attemptDue() const
+{
+    return !isConnected && millis() - scheduledAt >= retryDelayMs;
+}
+
+void ReconnectBackoff::attemptStarted()
+{
+    attempts++;
+}
+
+void ReconnectBackoff::attemptFailed(const char *reason)
+{
+    consecutiveFailures++;
+    recordFailure(reason);
+    schedule();
+}
+
+void ReconnectBackoff::connected()
+{
+    if (isConnected)
+    {
+        return;
+    }
+
+    isConnected = true;
+    connectedAt = millis();
+    successes++;
+    totalDisconnectedMs += connectedAt - disconnectedAt;
+}
+
+void ReconnectBackoff::disconnected(const char *reason)
+{
+    if (!isConnected)
+    {
+        return;
+    }
+
+    isConnected = false;
+    disconnectedAt = millis();
+    disconnects++;
+    recordFailure(reason);
+
+    // A connection that dropped right away (e.g. backend still starting)
+    // keeps backing off; a stable one starts over
+    if (disconnectedAt - connectedAt >= WS_RECONNECT_STABLE_TIME)
+    {
+        consecutiveFailures = 0;
+    }
+    else
+    {
+        consecutiveFailures++;
+    }
+    schedule();
+}
+
+unsigned long ReconnectBackoff::getRetryInMs() const
+{
+    if (isConnected)
+    {
+        return 0;
+    }
+
+    unsigned long elapsed = millis() - scheduledAt;
+    return elapsed < retryDelayMs ? retryDelayMs - elapsed : 0;
+}
+
+unsigned long ReconnectBackoff::getDisconnectedMs() const
+{
+    return totalDisconnectedMs + (isConnected ? 0 : millis() - disconnectedAt);
+}
+
+void ReconnectBackoff::report(JsonObject out) const
+{
+    out["attempts"] = attempts;
+    out["successes"] = successes;
+    out["disconnects"] = disconnects;
+    out["consecutiveFailures"] = consecutiveFailures;
+    out["disconnectedMs"] = getDisconnectedMs();
+    if (lastFailure[0])
+    {
+        out["lastFailure"] = lastFailure;
+        out["lastFailureAt"] = lastFailureAt; // millis(), stable across delta reports
+    }
+}
+
+void ReconnectBackoff::recordFailure(const char *reason)
+{
+    strlcpy(lastFailure, reason, sizeof(lastFailure));
+    lastFailureAt = millis();
+}
+
+void ReconnectBackoff::schedule()
+{
+    unsigned long ceiling = WS_RECONNECT_BACKOFF_BASE;
+    for (int i = 0; i < consecutiveFailures && ceiling < WS_RECONNECT_BACKOFF_MAX; i++)
+    {
+        ceiling *= 2;
+    }
+    ceiling = min(ceiling, (unsigned long)WS_RECONNECT_BACKOFF_MAX);
+
+    // Full jitter: anywhere between now and the ceiling. random() draws from
+    // the hardware RNG, so devices booted together still spread out.
+    retryDelayMs = random(ceiling + 1);
+    scheduledAt = millis();
+
+    Serial.printf("⏳ WebSocket reconnect in %lu ms (backoff ceiling %lu ms)\n",
+                  (unsigned long)retryDelayMs, (unsigned long)ceiling);
+}
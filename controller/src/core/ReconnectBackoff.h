@@ -0,0 +1,65 @@
+#ifndef RECONNECT_BACKOFF_H
+#define RECONNECT_BACKOFF_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+
+/**
+ * Reconnect scheduling and connection metrics for the WebSocket client
+ *
+ * After every failed attempt the backoff ceiling doubles from
+ * WS_RECONNECT_BACKOFF_BASE up to WS_RECONNECT_BACKOFF_MAX, and the next
+ * attempt is scheduled at a uniformly random delay below it ("full jitter"),
+ * so a fleet that lost the backend at the same moment does not reconnect in
+ * lockstep. A connection that stays up for WS_RECONNECT_STABLE_TIME resets
+ * the backoff; one that drops sooner counts as another failure.
+ */
+class ReconnectBackoff
+{
+public:
+    ReconnectBackoff();
+
+    /**
+     * Whether the client is disconnected and the scheduled delay has passed
+     */
+    bool attemptDue() const;
+
+    void attemptStarted();
+    void attemptFailed(const char *reason);
+    void connected();
+
+    /**
+     * Connection lost; ignored unless connected() was called before
+     */
+    void disconnected(const char *reason);
+
+    int getConsecutiveFailures() const { return consecutiveFailures; }
+    unsigned long getRetryInMs() const;
+    unsigned long getDisconnectedMs() const;
+
+    /**
+     * Add attempt/success counters, time disconnected and the last failure
+     */
+    void report(JsonObject out) const;
+
+private:
+    bool isConnected;
+    int consecutiveFailures;
+    unsigned long scheduledAt;
+    unsigned long retryDelayMs;
+    unsigned long connectedAt;
+    unsigned long disconnectedAt;
+
+    uint32_t attempts;
+    uint32_t successes;
+    uint32_t disconnects;
+    unsigned long totalDisconnectedMs; // Completed outages only
+    char lastFailure[48];
+    unsigned long lastFailureAt;
+
+    void recordFailure(const char *reason);
+    void schedule();
+};
+
+#endif
@@ -1,8 +1,99 @@
 #include "WSClient.h"
 
-WSClient::WSClient(DeviceManager *devManager, LightManager *lightMgr)
-    : deviceManager(devManager), lightManager(lightMgr), isConnected(false), lastHeartbeat(0), lastConnectionAttempt(0)
+// Every inbound event the device handles. The filter is applied while parsing,
+// so a handler only sees the fields listed here.
+const WSClient::EventRoute WSClient::eventRoutes[WSClient::EVENT_ROUTE_COUNT] = {
+    {eventHash("colorPalette"), "colorPalette", &WSClient::handleColorPalette,
+     "{\"messageId\":true,\"senderId\":true,\"senderName\":true,\"timestamp\":true,\"sentAt\":true,\"colors\":[{\"hex\":true}]}"},
+    {eventHash("deviceRegistered"), "deviceRegistered", &WSClient::handleDeviceRegistered,
+     "{\"data\":{\"deviceId\":true,\"pairingCode\":true,\"claimed\":true,\"paletteFormat\":true,\"sessionToken\":true}}"},
+    {eventHash("deviceClaimed"), "deviceClaimed", &WSClient::handleDeviceClaimed,
+     "{\"data\":{\"userEmail\":true,\"userName\":true}}"},
+    {eventHash("setupComplete"), "setupComplete", &WSClient::handleSetupComplete,
+     "{\"data\":{\"status\":true}}"},
+    {eventHash("lightingSystemConfig"), "lightingSystemConfig", &WSClient::handleLightingSystemConfig,
+     "{\"data\":{\"systemType\":true,\"hostAddress\":true,\"port\":true,\"authToken\":true,\"customConfig\":true,\"targetIndex\":true,\"requestId\":true}}"},
+    {eventHash("testLightingSystem"), "testLightingSystem", &WSClient::handleTestLightingSystem,
+     "{\"data\":{\"deviceId\":true,\"requestId\":true}}"},
+    {eventHash("factoryReset"), "factoryReset", &WSClient::handleFactoryReset,
+     "{\"event\":true}"},
+    {eventHash("timeSync"), "timeSync", &WSClient::handleTimeSync,
+     "{\"data\":{\"t0\":true,\"serverTime\":true}}"},
+    {eventHash("requestStatus"), "requestStatus", &WSClient::handleRequestStatus,
+     "{\"event\":true}"},
+    {eventHash("sessionResumed"), "sessionResumed", &WSClient::handleSessionResumed,
+     "{\"data\":{\"paletteFormat\":true,\"replay\":true}}"},
+    {eventHash("sessionRejected"), "sessionRejected", &WSClient::handleSessionRejected,
+     "{\"event\":true}"},
+    {eventHash("registrationError"), "registrationError", &WSClient::handleRegistrationError,
+     "{\"data\":{\"error\":true}}"},
+};
+
+WSClient::WSClient(DeviceManager *devManager, LightingTask *lightTask)
+    : deviceManager(devManager), lightingTask(lightTask), isConnected(false), sessionReady(false), lastHeartbeat(0), binaryPalettes(false), unknownEvents(0), frameReceivedAt(0), frameParseStart(0), lastTelemetryAt(0), outboundHoldStart(0), outboundHoldMs(0), bootTimeline(nullptr), bootReported(false), loopScheduler(nullptr), registrationHeld(false), registrationRejected(false)
 {
+    memset(eventStats, 0, sizeof(eventStats));
+    memset(&outboundStats, 0, sizeof(outboundStats));
+    buildInboundFilters();
+
+    jobs.setListener([this](const Job &job)
+                     { reportJob(job); });
+}
+
+void WSClient::buildInboundFilters()
+{
+    // Filters are built once from the route table
+    eventFilter["event"] = true;
+
+    for (int i = 0; i < EVENT_ROUTE_COUNT; i++)
+    {
+        deserializeJson(routeFilters[i], eventRoutes[i].filter);
+    }
+}
+
+int WSClient::findEventRoute(const char *event)
+{
+    uint32_t hash = eventHash(event);
+    for (int i = 0; i < EVENT_ROUTE_COUNT; i++)
+    {
+        // The name check guards against hash collisions
+        if (eventRoutes[i].hash == hash && strcmp(eventRoutes[i].name, event) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void WSClient::printEventStats()
+{
+    Serial.println("📊 WebSocket Event Statistics:");
+    Serial.println("  event                  count      bytes   avg us   max us");
+    for (int i = 0; i < EVENT_ROUTE_COUNT; i++)
+    {
+        const EventStats &stats = eventStats[i];
+        Serial.printf("  %-20s %7lu %10lu %8lu %8lu\n", eventRoutes[i].name, (unsigned long)stats.count, (unsigned long)stats.bytes,
+                      (unsigned long)(stats.count ? stats.handlerMicros / stats.count : 0), (unsigned long)stats.maxHandlerMicros);
+    }
+    Serial.printf("  unknown events: %lu\n", (unsigned long)unknownEvents);
+    Serial.printf("  palette format: %s\n", binaryPalettes ? PALETTE_FRAME_FORMAT : "json");
+    Serial.printf("  parse arena: peak %u of %u bytes, %lu heap fallbacks\n", (unsigned)inboundArena.peak(),
+                  (unsigned)WS_JSON_ARENA_SIZE, (unsigned long)inboundArena.getFallbackCount());
+
+    const OutboundStats &out = outboundStats;
+    Serial.printf("  outbound: %lu messages in %lu frames, %lu bytes, peak batch %u of %u bytes\n",
+                  (unsigned long)out.messages, (unsigned long)out.frames, (unsigned long)out.bytes,
+                  (unsigned)out.peakBatch, (unsigned)outbound.capacity());
+    Serial.printf("  outbound: %lu failed sends, %lu oversized, %lu dropped, %lu reports skipped while congested\n",
+                  (unsigned long)out.failedSends, (unsigned long)out.oversized, (unsigned long)out.dropped,
+                  (unsigned long)out.skippedReports);
+
+    JsonDocument connection;
+    reconnect.report(connection.to<JsonObject>());
+    pingMonitor.report(connection.as<JsonObject>());
+    Serial.print("  connection: ");
+    serializeJson(connection, Serial);
+    Serial.println();
 }
 
 void WSClient::begin(const String &url)
@@ -10,7 +101,7 @@ void WSClient::begin(const String &url)
     serverUrl = url;
 
     // Setup WebSocket event callbacks
-    client.onMessage([this](WebsocketsMessage message)
+    client.onMessage([this](const WebsocketsMessage &message)
                      { onMessageCallback(message); });
 
     client.onEvent([this](WebsocketsEvent event, String data)
@@ -30,21 +121,38 @@ bool WSClient::connect()
     if (serverUrl.length() == 0)
     {
         Serial.println("❌ No server URL configured for WebSocket connection");
+        reconnect.attemptFailed("no server URL");
         return false;
     }
 
     Serial.println("🔌 Attempting WebSocket connection to: " + serverUrl);
 
+    reconnect.attemptStarted();
     bool connected = client.connect(serverUrl);
 
     if (connected)
     {
         Serial.println("✅ WebSocket connected successfully!");
         isConnected = true;
-        lastConnectionAttempt = millis();
+        sessionReady = false;
+        reconnect.connected();
+        pingMonitor.connectionOpened();
 
-        // Register device immediately after connection
-        registerDevice();
+        // Nothing queued for the previous connection is sent on this one
+        resetOutbound();
+
+        // Resume the previous session, or register immediately after
+        // connection; registration and the initial status reports leave as
+        // one frame
+        if (registrationHeld)
+        {
+            Serial.println("⏳ WebSocket open, registration waits for the HTTP registration");
+        }
+        else if (!resumeSession())
+        {
+            registerDevice();
+        }
+        flushOutbound();
 
         return true;
     }
@@ -52,17 +160,38 @@ bool WSClient::connect()
     {
         Serial.println("❌ WebSocket connection failed");
         isConnected = false;
-        lastConnectionAttempt = millis();
+        reconnect.attemptFailed("connect failed");
         return false;
     }
 }
 
+void WSClient::releaseRegistration()
+{
+    if (!registrationHeld)
+    {
+        return;
+    }
+
+    registrationHeld = false;
+    if (isConnected)
+    {
+        if (!resumeSession())
+        {
+            registerDevice();
+        }
+        flushOutbound();
+    }
+}
+
 void WSClient::disconnect()
 {
     if (isConnected)
     {
         client.close();
         isConnected = false;
+        sessionReady = false;
+        reconnect.disconnected("closed locally");
+        resetOutbound();
         Serial.println("🔌 WebSocket disconnected");
     }
 }
@@ -74,15 +203,33 @@ bool WSClient::isClientConnected()
 
 void WSClient::loop()
 {
+    processLightingEvents();
+    jobs.loop();
+
     if (isConnected)
     {
         client.poll();
+        checkConnectionHealth();
+    }
 
+    // The health check may have just closed a dead connection
+    if (isConnected)
+    {
         // Send heartbeat if needed
         if (shouldSendHeartbeat())
         {
             sendHeartbeat();
         }
+
+        // Report the boot timeline as soon as it is final
+        if (bootTimeline && bootTimeline->isComplete() && !bootReported)
+        {
+            bootReported = true;
+            sendDeviceStatus();
+        }
+
+        // Everything queued during this pass goes out as one frame
+        flushOutbound();
     }
     else
     {
@@ -98,27 +245,53 @@ void WSClient::sendHeartbeat()
 {
     if (isClientConnected())
     {
-        client.ping();
+        sendPing();
         lastHeartbeat = millis();
         Serial.println("💓 Heartbeat sent");
 
         // Update device online status
         deviceManager->setOnlineStatus(true);
 
-        // Send periodic status updates every 10 heartbeats (roughly every 5 minutes if heartbeat is every 30 seconds)
+        // Send lighting status and a time sync every 10 heartbeats (roughly every 5 minutes if heartbeat is every 30 seconds).
+        // Device status has its own cadence, see sendPeriodicStatus().
         static int heartbeatCount = 0;
         heartbeatCount++;
 
-        if (heartbeatCount >= 10)
+        if (heartbeatCount >= 10 && isOutboundCongested())
+        {
+            // Try again on the next heartbeat instead of adding to the backlog
+            outboundStats.skippedReports++;
+            Serial.println("⏳ WebSocket congested, postponing periodic status updates");
+        }
+        else if (heartbeatCount >= 10)
         {
             heartbeatCount = 0;
             Serial.println("📊 Sending periodic status updates...");
-            sendDeviceStatus();
             sendLightingSystemStatus();
+            sendTimeSync();
         }
     }
 }
 
+bool WSClient::sendPeriodicStatus()
+{
+    if (!isClientConnected())
+    {
+        return false;
+    }
+
+    if (isOutboundCongested())
+    {
+        // The socket is up, just slow; the next interval catches up
+        outboundStats.skippedReports++;
+        Serial.println("⏳ WebSocket congested, postponing device status");
+        return true;
+    }
+
+    sendDeviceStatus();
+    return true;
+}
+
 bool WSClient::registerDevice()
 {
     if (!isClientConnected())
@@ -144,12 +317,21 @@ bool WSClient::registerDevice()
         doc["data"]["pairingCode"] = deviceInfo.pairingCode;
     }
 
-    String message;
-    serializeJson(doc, message);
+    // Palette formats in order of preference; JSON is always understood
+    JsonArray paletteFormats = doc["data"]["paletteFormats"].to<JsonArray>();
+#if WS_BINARY_PALETTE_FRAMES
+    paletteFormats.add(PALETTE_FRAME_FORMAT);
+#endif
+    paletteFormats.add("json");
+    binaryPalettes = false;
 
-    client.send(message);
+    // A new connection starts with full status snapshots
+    lastDeviceStatus.clear();
+    lastLightingStatus.clear();
 
-    Serial.println("📤 Device registration message sent");
+    queueMessage(doc);
+
+    Serial.println("📤 Device registration message queued");
     Serial.println("🆔 Device ID: " + deviceInfo.deviceId);
     Serial.println("📡 MAC Address: " + deviceInfo.macAddress);
 
@@ -162,16 +344,159 @@ bool WSClient::registerDevice()
     // Send initial status updates after registration
     sendDeviceStatus();
     sendLightingSystemStatus();
+    sendTimeSync();
 
     return true;
 }
 
+bool WSClient::resumeSession()
+{
+    if (!deviceManager->hasSession() || !deviceManager->isProvisioned())
+    {
+        return false;
+    }
+
+    JsonDocument doc;
+    doc["event"] = "resumeSession";
+    doc["data"]["deviceId"] = deviceManager->getDeviceId();
+    doc["data"]["sessionToken"] = deviceManager->getSessionToken();
+
+    Serial.println("⚡ Resuming WebSocket session...");
+    return queueMessage(doc);
+}
+
 void WSClient::sendMessage(const String &message)
 {
     if (isClientConnected())
     {
-        client.send(message);
+        queueMessage(message.c_str(), message.length());
+    }
+}
+
+bool WSClient::queueMessage(const JsonDocument &doc)
+{
+    if (!isConnected)
+    {
+        return false;
+    }
+
+    if (outbound.add(doc))
+    {
+        return true;
+    }
+
+    // Only when the batch is full or the message is larger than the buffer
+    String message;
+    serializeJson(doc, message);
+    return queueMessage(message.c_str(), message.length());
+}
+
+bool WSClient::queueMessage(const char *json, size_t length)
+{
+    if (!isConnected)
+    {
+        return false;
+    }
+
+    if (outbound.add(json, length))
+    {
+        return true;
+    }
+
+    // Batch is full: send it now, even while congested, rather than drop messages
+    if (!outbound.isEmpty() && flushOutbound(true) && outbound.add(json, length))
+    {
+        return true;
+    }
+
+    if (outbound.isEmpty())
+    {
+        // Larger than the whole batch buffer, goes out in a frame of its own
+        outboundStats.oversized++;
+        outboundStats.frames++;
+        outboundStats.messages++;
+        outboundStats.bytes += length;
+        return client.send(json, length);
+    }
+
+    outboundStats.dropped++;
+    Serial.println("⚠ Outbound batch full, message dropped");
+    return false;
+}
+
+bool WSClient::flushOutbound(bool force)
+{
+    if (outbound.isEmpty())
+    {
+        return true;
+    }
+
+    if (!isConnected || (!force && isOutboundHeld()))
+    {
+        return false;
+    }
+
+    if (outbound.used() > outboundStats.peakBatch)
+    {
+        outboundStats.peakBatch = outbound.used();
+    }
+
+    size_t length = outbound.frameLength();
+    int messages = outbound.messageCount();
+
+    unsigned long started = millis();
+    bool sent = client.send(outbound.frame(), length);
+    unsigned long elapsed = millis() - started;
+
+    if (!sent)
+    {
+        // Keep the batch; it is retried after the hold or discarded on reconnect
+        outboundStats.failedSends++;
+        holdOutbound(WS_OUTBOUND_RETRY_INTERVAL);
+        Serial.println("⚠ WebSocket send failed, keeping " + String(messages) + " queued messages");
+        return false;
+    }
+
+    outbound.clear();
+    outboundStats.frames++;
+    outboundStats.messages += messages;
+    outboundStats.bytes += length;
+
+    // A blocking send means the TCP window is full; let messages pile up in
+    // the batch for as long as the send took before writing again
+    if (elapsed > WS_OUTBOUND_SLOW_SEND)
+    {
+        holdOutbound(elapsed);
+        Serial.printf("⏳ WebSocket send took %lu ms, batching for longer\n", (unsigned long)elapsed);
+    }
+
+    return true;
+}
+
+bool WSClient::isOutboundCongested()
+{
+    return isOutboundHeld() || outbound.used() > outbound.capacity() * 3 / 4;
+}
+
+void WSClient::holdOutbound(unsigned long ms)
+{
+    outboundHoldStart = millis();
+    outboundHoldMs = ms;
+}
+
+bool WSClient::isOutboundHeld()
+{
+    if (outboundHoldMs && millis() - outboundHoldStart >= outboundHoldMs)
+    {
+        outboundHoldMs = 0;
     }
+    return outboundHoldMs != 0;
+}
+
+void WSClient::resetOutbound()
+{
+    outbound.clear();
+    outboundHoldMs = 0;
 }
 
 bool WSClient::shouldSendHeartbeat()
@@ -181,65 +506,80 @@ bool WSClient::shouldSendHeartbeat()
 
 bool WSClient::shouldRetryConnection()
 {
-    return (millis() - lastConnectionAttempt) > REGISTRATION_RETRY_INTERVAL;
+    // Attempts without a WiFi link would only stretch the backoff
+    return WiFi.status() == WL_CONNECTED && reconnect.attemptDue();
 }
 
-void WSClient::onMessageCallback(WebsocketsMessage message)
+void WSClient::onMessageCallback(const WebsocketsMessage &message)
 {
-    Serial.println("📨 WebSocket message received");
+    // Parse straight from the frame buffer into the arena; nothing from the
+    // previous message is referenced any more
+    const WSString &frame = message.rawData();
+    unsigned long parseStart = micros();
+    frameReceivedAt = millis();
+    frameParseStart = parseStart;
+    inboundArena.reset();
 
-    // Parse JSON message
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, message.data());
+    Serial.printf("📨 WebSocket message received (%u bytes)\n", (unsigned)frame.size());
+
+    if (message.isBinary())
+    {
+        handleBinaryFrame(reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+        return;
+    }
 
+    JsonDocument doc(&inboundArena);
+
+    // First pass: only the event name
+    DeserializationError error = deserializeJson(doc, frame.c_str(), frame.size(),
+                                                 DeserializationOption::Filter(eventFilter));
     if (error)
     {
-        Serial.println("❌ JSON parsing failed: " + String(error.c_str()));
+        Serial.printf("❌ JSON parsing failed: %s\n", error.c_str());
         return;
     }
 
-    // Check message type
-    if (doc["event"].is<String>())
+    const char *eventName = doc["event"];
+    if (!eventName)
     {
-        String event = doc["event"];
-        Serial.println("📝 Event: " + event);
+        Serial.println("⚠ Message missing event field");
+        return;
+    }
 
-        if (event == "colorPalette")
-        {
-            handleColorPalette(doc);
-        }
-        else if (event == "deviceRegistered")
-        {
-            handleDeviceRegistered(doc);
-        }
-        else if (event == "deviceClaimed")
-        {
-            handleDeviceClaimed(doc);
-        }
-        else if (event == "setupComplete")
-        {
-            handleSetupComplete(doc);
-        }
-        else if (event == "lightingSystemConfig")
-        {
-            handleLightingSystemConfig(doc);
-        }
-        else if (event == "testLightingSystem")
-        {
-            handleTestLightingSystem(doc);
-        }
-        else if (event == "factoryReset")
-        {
-            handleFactoryReset(doc);
-        }
-        else
-        {
-            Serial.println("⚠ Unknown event type: " + event);
-        }
+    char event[WS_EVENT_NAME_LENGTH];
+    strlcpy(event, eventName, sizeof(event));
+
+    int route = findEventRoute(event);
+    if (route < 0)
+    {
+        unknownEvents++;
+        Serial.printf("⚠ Unknown event type: %s\n", event);
+        return;
     }
-    else
+
+    // Second pass: the fields this event's handler reads
+    doc.clear();
+    inboundArena.reset();
+    error = deserializeJson(doc, frame.c_str(), frame.size(), DeserializationOption::Filter(routeFilters[route]));
+    if (error)
     {
-        Serial.println("⚠ Message missing event field");
+        Serial.printf("❌ JSON parsing failed: %s\n", error.c_str());
+        return;
+    }
+
+    unsigned long handlerStart = micros();
+    Serial.printf("📝 Event: %s (parsed in %lu us, %u bytes)\n", event, handlerStart - parseStart, (unsigned)inboundArena.used());
+
+    (this->*eventRoutes[route].handler)(doc);
+
+    uint32_t handlerMicros = micros() - handlerStart;
+    EventStats &stats = eventStats[route];
+    stats.count++;
+    stats.bytes += frame.size();
+    stats.handlerMicros += handlerMicros;
+    if (handlerMicros > stats.maxHandlerMicros)
+    {
+        stats.maxHandlerMicros = handlerMicros;
     }
 }
 
@@ -255,6 +595,9 @@ void WSClient::onEventsCallback(WebsocketsEvent event, String data)
     case WebsocketsEvent::ConnectionClosed:
         Serial.println("🔌 WebSocket connection closed");
         isConnected = false;
+        sessionReady = false;
+        reconnect.disconnected("connection closed");
+        resetOutbound();
         deviceManager->setOnlineStatus(false);
         break;
 
@@ -263,32 +606,138 @@ void WSClient::onEventsCallback(WebsocketsEvent event, String data)
         break;
 
     case WebsocketsEvent::GotPong:
-        Serial.println("🏓 Pong received from server");
+        handlePong(data);
         break;
     }
 }
 
+void WSClient::sendPing()
+{
+    // The backend echoes the sequence number, which matches pong to ping
+    client.ping(String(pingMonitor.pingSent()));
+}
+
+void WSClient::handlePong(const String &payload)
+{
+    pingMonitor.pongReceived(payload);
+    Serial.printf("🏓 Pong received (RTT %lu ms, smoothed %lu ms, jitter %lu ms)\n",
+                  (unsigned long)pingMonitor.getLastRttMs(), (unsigned long)pingMonitor.getSmoothedRttMs(),
+                  (unsigned long)pingMonitor.getJitterMs());
+
+    // Backend HTTP requests take the same path as the WebSocket
+    deviceManager->setBackendTimeout(pingMonitor.getRequestTimeoutMs());
+}
+
+void WSClient::checkConnectionHealth()
+{
+    if (!pingMonitor.pongOverdue())
+    {
+        return;
+    }
+
+    pingMonitor.pongMissed();
+
+    if (pingMonitor.isDead())
+    {
+        // TCP may not notice a half-open connection for minutes
+        Serial.printf("💀 %d pongs missed, closing dead WebSocket connection\n", pingMonitor.getMissedPongs());
+        reconnect.disconnected("pong timeout");
+        client.close();
+        isConnected = false;
+        sessionReady = false;
+        resetOutbound();
+        deviceManager->setOnlineStatus(false);
+        return;
+    }
+
+    // Probe again right away instead of waiting for the next heartbeat
+    Serial.printf("⚠ Pong overdue (%d missed), pinging again\n", pingMonitor.getMissedPongs());
+    sendPing();
+}
+
 void WSClient::handleColorPalette(JsonDocument &doc)
 {
+    // Decode straight into currentPalette: fixed-size fields and the in-place
+    // hex parser keep this path free of heap allocations
     Serial.println("\n🎨 ===== COLOR PALETTE RECEIVED =====");
 
-    // Use a temporary legacy palette to extract data from JSON
-    LegacyColorPalette legacyPalette;
+    const char *messageId = doc["messageId"] | "";
+    const char *senderId = doc["senderId"] | "";
+    const char *senderName = doc["senderName"] | "";
+
+    currentPalette = ColorPalette();
+    currentPalette.setMessageId(messageId);
+    currentPalette.setSenderName(senderName);
+    snprintf(currentPalette.name, sizeof(currentPalette.name), "From %s", senderName);
 
-    // Extract palette data
-    legacyPalette.messageId = doc["messageId"].as<String>();
-    legacyPalette.senderId = doc["senderId"].as<String>();
-    legacyPalette.senderName = doc["senderName"].as<String>();
-    legacyPalette.timestamp = doc["timestamp"];
+    JsonArrayConst colors = doc["colors"];
+    currentPalette.colorCount = min((int)colors.size(), MAX_COLORS);
+
+    for (int i = 0; i < currentPalette.colorCount; i++)
+    {
+        // Invalid colors stay black, as before
+        RGBColor::parseHex(colors[i]["hex"] | "", currentPalette.colors[i]);
+    }
 
-    // Extract colors
-    JsonArray colors = doc["colors"];
-    legacyPalette.colorCount = min((int)colors.size(), 10);
+    // Backend times in ms since epoch; strings (older backends) count as unknown
+    uint64_t createdAt = doc["timestamp"].as<uint64_t>();
+    uint64_t sentAt = doc["sentAt"].as<uint64_t>();
+    uint32_t parseMicros = micros() - frameParseStart;
 
-    Serial.println("📧 Message ID: " + legacyPalette.messageId);
-    Serial.println("👤 From: " + legacyPalette.senderName + " (" + legacyPalette.senderId + ")");
-    Serial.println("⏰ Timestamp: " + String(legacyPalette.timestamp));
-    Serial.println("🌈 Number of colors: " + String(legacyPalette.colorCount));
+    Serial.printf("📧 Message ID: %s\n", messageId);
+    Serial.printf("👤 From: %s (%s)\n", senderName, senderId);
+    Serial.print("⏰ Timestamp: ");
+    serializeJson(doc["timestamp"], Serial);
+    Serial.println();
+
+    showReceivedPalette(parseMicros, createdAt, sentAt);
+}
+
+void WSClient::handleBinaryFrame(const uint8_t *data, size_t length)
+{
+    unsigned long handlerStart = micros();
+    uint64_t timestamp = 0;
+    uint64_t sentAt = 0;
+
+    if (length < 2 || data[0] != PALETTE_FRAME_MAGIC)
+    {
+        unknownEvents++;
+        Serial.println("⚠ Unknown binary frame");
+        return;
+    }
+
+    ColorPalette palette;
+    if (!PaletteFrame::decode(data, length, palette, timestamp, sentAt))
+    {
+        Serial.println("❌ Malformed binary palette frame");
+        return;
+    }
+    currentPalette = palette;
+    uint32_t parseMicros = micros() - frameParseStart;
+
+    Serial.println("\n🎨 ===== COLOR PALETTE RECEIVED (binary) =====");
+    Serial.printf("📧 Message ID: %s\n", currentPalette.messageId);
+    Serial.printf("👤 From: %s\n", currentPalette.senderName);
+    Serial.printf("⏰ Timestamp: %llu\n", (unsigned long long)timestamp);
+
+    showReceivedPalette(parseMicros, timestamp, sentAt);
+
+    // Binary palettes share the colorPalette counters
+    static const int paletteRoute = findEventRoute("colorPalette");
+    uint32_t handlerMicros = micros() - handlerStart;
+    EventStats &stats = eventStats[paletteRoute];
+    stats.count++;
+    stats.bytes += length;
+    stats.handlerMicros += handlerMicros;
+    if (handlerMicros > stats.maxHandlerMicros)
+    {
+        stats.maxHandlerMicros = handlerMicros;
+    }
+}
+
+void WSClient::showReceivedPalette(uint32_t parseMicros, uint64_t createdAt, uint64_t sentAt)
+{
+    Serial.printf("🌈 Number of colors: %d\n", currentPalette.colorCount);
     Serial.println();
 
     Serial.println("🎨 Color Palette:");
@@ -296,28 +745,22 @@ void WSClient::handleColorPalette(JsonDocument &doc)
     Serial.println("| Color # | Hex Code |");
     Serial.println("+---------+----------+");
 
-    for (int i = 0; i < legacyPalette.colorCount; i++)
+    for (int i = 0; i < currentPalette.colorCount; i++)
     {
-        String hexColor = colors[i]["hex"];
-        legacyPalette.colors[i] = hexColor;
-
-        // Format output nicely
-        String colorNum = String(i + 1);
-        if (colorNum.length() == 1)
-            colorNum = " " + colorNum;
-
-        Serial.println("|    " + colorNum + "    |  " + hexColor + "  |");
+        const RGBColor &color = currentPalette.colors[i];
+        Serial.printf("|    %2d    |  #%02X%02X%02X  |\n", i + 1, color.r, color.g, color.b);
     }
 
     Serial.println("+---------+----------+");
     Serial.println();
 
-    // Convert to the current palette format
-    currentPalette = convertToLightPalette(legacyPalette);
-
     // Display the palette
     displayColorPaletteSerial();
-    displayColorPaletteOnLights();
+    uint32_t commandId = displayColorPaletteOnLights();
+    if (commandId)
+    {
+        paletteLatency.track(commandId, frameReceivedAt, parseMicros, createdAt, sentAt);
+    }
 
     Serial.println("🎨 =====================================\n");
 }
@@ -333,16 +776,69 @@ void WSClient::handleDeviceRegistered(JsonDocument &doc)
         Serial.println("🆔 Server confirmed Device ID: " + serverDeviceId);
     }
 
+    // When the HTTP registration was skipped, this is the only place the
+    // claim status and pairing code are refreshed
+    if (doc["data"]["claimed"].is<bool>())
+    {
+        bool claimed = doc["data"]["claimed"];
+        if (claimed != deviceManager->isProvisioned())
+        {
+            deviceManager->setProvisioned(claimed);
+        }
+    }
+
     if (doc["data"]["pairingCode"].is<String>())
     {
         String pairingCode = doc["data"]["pairingCode"].as<String>();
+        deviceManager->setPairingCode(pairingCode);
         Serial.println("🔑 Pairing Code: " + pairingCode);
         Serial.println("📱 Use this code in the mobile app to claim this device");
     }
 
+    const char *paletteFormat = doc["data"]["paletteFormat"] | "json";
+    binaryPalettes = strcmp(paletteFormat, PALETTE_FRAME_FORMAT) == 0;
+    Serial.printf("🎨 Palette format: %s\n", paletteFormat);
+
+    // Presented by resumeSession() on the next reconnect
+    deviceManager->setSessionToken(doc["data"]["sessionToken"] | "");
+    sessionReady = true;
+
     Serial.println("✅ ================================\n");
 }
 
+void WSClient::handleSessionResumed(JsonDocument &doc)
+{
+    const char *paletteFormat = doc["data"]["paletteFormat"] | "json";
+    binaryPalettes = strcmp(paletteFormat, PALETTE_FRAME_FORMAT) == 0;
+
+    Serial.printf("⚡ Session resumed (palette format %s)\n", paletteFormat);
+    sessionReady = true;
+    if (doc["data"]["replay"] | false)
+    {
+        Serial.println("🎨 Backend is replaying a palette missed while offline");
+    }
+
+    // Status snapshots from before the outage still stand on the backend
+    sendDeviceStatus();
+}
+
+void WSClient::handleSessionRejected(JsonDocument &doc)
+{
+    Serial.println("🔁 Session no longer valid on the backend, registering again");
+    deviceManager->setSessionToken("");
+    registerDevice();
+}
+
+void WSClient::handleRegistrationError(JsonDocument &doc)
+{
+    Serial.println("❌ WebSocket registration rejected: " + String(doc["data"]["error"] | "unknown error"));
+
+    // Whatever the backend holds for this device is stale
+    deviceManager->invalidateRegistration();
+    deviceManager->setSessionToken("");
+    registrationRejected = true;
+}
+
 void WSClient::handleDeviceClaimed(JsonDocument &doc)
 {
     Serial.println("\n🔐 ===== DEVICE CLAIMED =====");
@@ -359,19 +855,12 @@ void WSClient::handleDeviceClaimed(JsonDocument &doc)
     Serial.println("✅ Device is now provisioned and ready to use!");
 
     // Now that device is claimed by a user, we can start lighting system authentication
-    if (lightManager && lightManager->requiresUserAuthentication())
+    if (lightingTask && lightingTask->requiresUserAuthentication())
     {
         Serial.println("🔐 Starting lighting system authentication...");
 
-        // This will trigger user notifications (e.g., Nanoleaf button press) via the callback system
-        if (lightManager->authenticateLightingSystem())
-        {
-            Serial.println("✅ Lighting system authentication completed");
-        }
-        else
-        {
-            Serial.println("⚠ Lighting system authentication failed - can retry later");
-        }
+        // User notifications (e.g., Nanoleaf button press) and the result arrive as lighting events
+        jobs.track("lightingAuth", "", lightingTask->authenticate());
     }
 
     Serial.println("🔐 ==============================\n");
@@ -397,9 +886,9 @@ void WSClient::handleLightingSystemConfig(JsonDocument &doc)
 {
     Serial.println("\n⚡ ===== LIGHTING SYSTEM CONFIG =====");
 
-    if (!lightManager)
+    if (!lightingTask)
     {
-        Serial.println("❌ LightManager not available");
+        Serial.println("❌ Lighting task not available");
         return;
     }
 
@@ -411,6 +900,28 @@ void WSClient::handleLightingSystemConfig(JsonDocument &doc)
     int port = doc["data"]["port"] | 80; // Default to 80 if not specified
     String authToken = doc["data"]["authToken"].as<String>();
 
+    String customConfig;
+    if (doc["data"]["customConfig"].is<JsonObject>())
+    {
+        serializeJson(doc["data"]["customConfig"], customConfig);
+    }
+
+    // Progress and the result are reported as job events carrying this id
+    String requestId = doc["data"]["requestId"] | "";
+
+    // Additional targets are driven alongside the primary system
+    int targetIndex = doc["data"]["targetIndex"] | 0;
+    if (targetIndex > 0)
+    {
+        Serial.println("🎯 Target Index: " + String(targetIndex));
+        jobs.track("lightingConfig", requestId,
+                   lightingTask->configure(targetIndex, systemType, hostAddress, port, authToken, customConfig, false));
+        Serial.println("⚡ ==============================\n");
+        return;
+    }
+
+    uint32_t commandId = 0;
+
     if (systemType == "nanoleaf")
     {
         Serial.println("🍃 Configuring Nanoleaf lighting system...");
@@ -419,91 +930,29 @@ void WSClient::handleLightingSystemConfig(JsonDocument &doc)
         if (hostAddress.length() == 0 || hostAddress == "null" || hostAddress == "undefined")
         {
             Serial.println("🔍 No host address provided - using mDNS discovery for Nanoleaf");
-            // Configure without host address - let the LightManager use mDNS discovery
-            bool success = lightManager->configure(systemType, "", 0, authToken);
-
-            if (success)
-            {
-                Serial.println("✅ Nanoleaf system configured successfully via mDNS discovery!");
-
-                // Immediately start authentication process (which includes mDNS discovery)
-                Serial.println("🔐 Starting Nanoleaf mDNS discovery and authentication...");
-                Serial.println("🔍 This process will:");
-                Serial.println("   1. Initialize mDNS");
-                Serial.println("   2. Search for Nanoleaf devices on network");
-                Serial.println("   3. Test connectivity to found devices");
-                Serial.println("   4. Attempt authentication (may require button press)");
-                Serial.println("⏳ Please wait, this may take 30-60 seconds...");
-
-                Serial.println("🔬 DEBUG: About to call lightManager->authenticateLightingSystem()");
-                bool authResult = lightManager->authenticateLightingSystem();
-                Serial.println("🔬 DEBUG: lightManager->authenticateLightingSystem() returned: " + String(authResult ? "true" : "false"));
-
-                if (authResult)
-                {
-                    Serial.println("✅ Nanoleaf mDNS discovery and authentication completed successfully!");
-                }
-                else
-                {
-                    Serial.println("⚠ Nanoleaf discovery/authentication failed");
-                    Serial.println("💡 This could mean:");
-                    Serial.println("   - No Nanoleaf devices found on network");
-                    Serial.println("   - Devices found but authentication failed");
-                    Serial.println("   - User action required (press hold button on Nanoleaf)");
-                    Serial.println("   - Network/mDNS configuration issue");
-                }
-
-                // Send status update after authentication attempt
-                sendLightingSystemStatus();
-            }
-            else
-            {
-                Serial.println("❌ Failed to configure Nanoleaf system via mDNS discovery");
-            }
+            Serial.println("🔍 This process will:");
+            Serial.println("   1. Initialize mDNS");
+            Serial.println("   2. Search for Nanoleaf devices on network");
+            Serial.println("   3. Test connectivity to found devices");
+            Serial.println("   4. Attempt authentication (may require button press)");
+            Serial.println("⏳ Please wait, this may take 30-60 seconds...");
+            hostAddress = "";
+            port = 0;
         }
         else
         {
-            // Use provided host address
             Serial.println("🌐 Host Address: " + hostAddress);
             Serial.println("🔌 Port: " + String(port));
             if (authToken.length() > 0)
             {
                 Serial.println("🔑 Auth Token: [REDACTED]");
             }
-
-            bool success = lightManager->configure(systemType, hostAddress, port, authToken);
-
-            if (success)
-            {
-                Serial.println("✅ Nanoleaf system configured successfully!");
-
-                // For Nanoleaf, immediately start authentication process (which includes mDNS discovery)
-                Serial.println("🔐 Starting Nanoleaf authentication and discovery...");
-                Serial.println("🔍 This process will validate connection and authenticate");
-                Serial.println("⏳ Please wait, this may take 10-30 seconds...");
-
-                if (lightManager->authenticateLightingSystem())
-                {
-                    Serial.println("✅ Nanoleaf authentication and discovery completed successfully!");
-                }
-                else
-                {
-                    Serial.println("⚠ Nanoleaf authentication failed");
-                    Serial.println("💡 This could mean:");
-                    Serial.println("   - Invalid host address or port");
-                    Serial.println("   - Device not reachable on network");
-                    Serial.println("   - User action required (press hold button on Nanoleaf)");
-                    Serial.println("   - Invalid or expired auth token");
-                }
-
-                // Send status update after authentication attempt
-                sendLightingSystemStatus();
-            }
-            else
-            {
-                Serial.println("❌ Failed to configure Nanoleaf system");
-            }
+            Serial.println("🔍 This process will validate connection and authenticate");
+            Serial.println("⏳ Please wait, this may take 10-30 seconds...");
         }
+
+        // Configuration and authentication (which includes mDNS discovery) run on the lighting task
+        commandId = lightingTask->configure(0, systemType, hostAddress, port, authToken, "", true);
     }
     else if (systemType == "wled")
     {
@@ -512,53 +961,34 @@ void WSClient::handleLightingSystemConfig(JsonDocument &doc)
         Serial.println("🌐 Host Address: " + hostAddress);
         Serial.println("🔌 Port: " + String(port));
 
-        // Configure WLED system
-        bool success = lightManager->configure(systemType, hostAddress, port);
-
-        if (success)
-        {
-            Serial.println("✅ WLED system configured successfully!");
-        }
-        else
-        {
-            Serial.println("❌ Failed to configure WLED system");
-        }
-
-        // Send status update after WLED configuration
-        sendLightingSystemStatus();
+        commandId = lightingTask->configure(0, systemType, hostAddress, port, "", "", false);
     }
     else if (systemType == "ws2812")
     {
         Serial.println("💡 Configuring WS2812 lighting system...");
 
         // For WS2812, we might get pin and numLEDs in customConfig
-        JsonObject customConfig = doc["data"]["customConfig"];
-        int pin = customConfig["pin"] | DEFAULT_LED_PIN;
-        int numLEDs = customConfig["numLEDs"] | DEFAULT_NUM_LEDS;
+        JsonObject ledConfig = doc["data"]["customConfig"];
+        int pin = ledConfig["pin"] | DEFAULT_LED_PIN;
+        int numLEDs = ledConfig["numLEDs"] | DEFAULT_NUM_LEDS;
 
         Serial.println("📍 Pin: " + String(pin));
         Serial.println("💡 Number of LEDs: " + String(numLEDs));
 
-        // Configure WS2812 system (host and port are not used for direct GPIO)
-        bool success = lightManager->configure(systemType, "", 0, "", customConfig);
-
-        if (success)
-        {
-            Serial.println("✅ WS2812 system configured successfully!");
-        }
-        else
-        {
-            Serial.println("❌ Failed to configure WS2812 system");
-        }
-
-        // Send status update after WS2812 configuration
-        sendLightingSystemStatus();
+        // Host and port are not used for direct GPIO
+        commandId = lightingTask->configure(0, systemType, "", 0, "", customConfig, false);
     }
     else
     {
         Serial.println("❌ Unknown lighting system type: " + systemType);
     }
 
+    if (commandId != 0)
+    {
+        uint32_t jobId = jobs.track("lightingConfig", requestId, commandId);
+        Serial.println("📥 Lighting configuration queued (command " + String(commandId) + ", job " + String(jobId) + ")");
+    }
+
     Serial.println("⚡ ==============================\n");
 }
 
@@ -566,51 +996,22 @@ void WSClient::handleTestLightingSystem(JsonDocument &doc)
 {
     Serial.println("\n🧪 ===== LIGHTING SYSTEM TEST =====");
 
-    if (!lightManager)
-    {
-        Serial.println("❌ LightManager not available");
-
-        // Send failure response
-        sendMessage("{\"event\":\"lightingSystemTest\",\"data\":{\"deviceId\":\"" +
-                    deviceManager->getDeviceId() + "\",\"success\":false,\"error\":\"LightManager not available\"}}");
-        return;
-    }
-
     String deviceId = doc["data"]["deviceId"].as<String>();
-    Serial.println("🔍 Testing lighting system for device: " + deviceId);
-
-    // Test the lighting system connection
-    bool testSuccess = lightManager->testConnection();
-
-    if (testSuccess)
-    {
-        Serial.println("✅ Lighting system test passed!");
-
-        // Optionally show a test pattern
-        Serial.println("💡 Displaying test pattern...");
-
-        // Create a simple test palette
-        ColorPalette testPalette;
-        testPalette.colorCount = 3;
-        testPalette.colors[0] = RGBColor{255, 0, 0}; // Red
-        testPalette.colors[1] = RGBColor{0, 255, 0}; // Green
-        testPalette.colors[2] = RGBColor{0, 0, 255}; // Blue
 
-        lightManager->displayPalette(testPalette);
-
-        // Send success response
-        sendMessage("{\"event\":\"lightingSystemTest\",\"data\":{\"deviceId\":\"" +
-                    deviceId + "\",\"success\":true}}");
-    }
-    else
+    uint32_t commandId = lightingTask ? lightingTask->test(deviceId) : 0;
+    if (commandId == 0)
     {
-        Serial.println("❌ Lighting system test failed!");
+        Serial.println("❌ Lighting task not available");
 
         // Send failure response
         sendMessage("{\"event\":\"lightingSystemTest\",\"data\":{\"deviceId\":\"" +
-                    deviceId + "\",\"success\":false,\"error\":\"Connection test failed\"}}");
+                    deviceManager->getDeviceId() + "\",\"success\":false,\"error\":\"Lighting task not available\"}}");
+        return;
     }
 
+    jobs.track("lightingTest", doc["data"]["requestId"] | "", commandId);
+
+    Serial.println("🔍 Testing lighting system for device: " + deviceId);
     Serial.println("🧪 ==============================\n");
 }
 
@@ -622,8 +1023,8 @@ void WSClient::displayColorPaletteSerial()
     Serial.print("   Strip: ");
     for (int i = 0; i < currentPalette.colorCount; i++)
     {
-        String hexColor = LightControllerUtils::colorToHex(currentPalette.colors[i]);
-        Serial.print("[" + hexColor + "]");
+        const RGBColor &color = currentPalette.colors[i];
+        Serial.printf("[#%02X%02X%02X]", color.r, color.g, color.b);
         if (i < currentPalette.colorCount - 1)
         {
             Serial.print("-");
@@ -635,27 +1036,190 @@ void WSClient::displayColorPaletteSerial()
     Serial.println("   RGB Values:");
     for (int i = 0; i < currentPalette.colorCount; i++)
     {
-        RGBColor color = currentPalette.colors[i];
-        Serial.println("   Color " + String(i + 1) + ": RGB(" + String(color.r) + ", " + String(color.g) + ", " + String(color.b) + ")");
+        const RGBColor &color = currentPalette.colors[i];
+        Serial.printf("   Color %d: RGB(%u, %u, %u)\n", i + 1, color.r, color.g, color.b);
     }
 
     Serial.println("   💡 Colors displayed for demonstration");
     Serial.println("   🔧 In production, this would control physical LEDs");
 }
 
-void WSClient::setLightManager(LightManager *lightMgr)
+void WSClient::setLightingTask(LightingTask *lightTask)
+{
+    lightingTask = lightTask;
+    Serial.println("💡 Lighting task connected to WebSocket client");
+}
+
+void WSClient::processLightingEvents()
 {
-    lightManager = lightMgr;
-    Serial.println("💡 Light Manager connected to WebSocket client");
+    if (!lightingTask)
+    {
+        return;
+    }
 
-    // Set up user notification callback
-    if (lightManager)
+    LightEvent event;
+    while (lightingTask->pollEvent(event))
     {
-        lightManager->setUserNotificationCallback([this](const String &action, const String &instructions, int timeout)
-                                                  { handleUserNotification(action, instructions, timeout); });
+        handleLightingEvent(event);
     }
 }
 
+void WSClient::handleLightingEvent(const LightEvent &event)
+{
+    updateLightingJob(event);
+
+    switch (event.type)
+    {
+    case LIGHT_EVENT_PROGRESS:
+        Serial.println("⏳ Lighting command " + String(event.commandId) + ": " + event.stage + " (" + String(event.progress) + "%)");
+        break;
+
+    case LIGHT_EVENT_PALETTE_DISPLAYED:
+        paletteLatency.complete(event.commandId, event.report);
+        if (event.success)
+        {
+            Serial.println("✅ Palette " + event.reference + " displayed on lights in " + String(event.report.latencyMs) + " ms");
+        }
+        else
+        {
+            Serial.println("❌ Failed to display palette " + event.reference + " on " +
+                           String(event.report.targetCount - event.report.successCount) + " target(s)");
+        }
+        break;
+
+    case LIGHT_EVENT_CONFIGURED:
+        // The registration payload carries the lighting configuration
+        deviceManager->invalidateRegistrationPayload();
+        if (event.success)
+        {
+            Serial.println("✅ " + event.reference + " lighting system configured successfully!");
+        }
+        else
+        {
+            Serial.println("⚠ " + event.reference + " configuration or authentication failed");
+            Serial.println("💡 This could mean:");
+            Serial.println("   - Invalid host address or port");
+            Serial.println("   - Device not reachable on network");
+            Serial.println("   - User action required (press hold button on Nanoleaf)");
+            Serial.println("   - Invalid or expired auth token");
+        }
+        sendLightingSystemStatus(event.status);
+        break;
+
+    case LIGHT_EVENT_AUTHENTICATED:
+        deviceManager->invalidateRegistrationPayload(); // New auth token
+        if (event.success)
+        {
+            Serial.println("✅ Lighting system authentication completed");
+        }
+        else
+        {
+            Serial.println("⚠ Lighting system authentication failed - can retry later");
+        }
+        sendLightingSystemStatus(event.status);
+        break;
+
+    case LIGHT_EVENT_TESTED:
+        if (event.reference.length() == 0)
+        {
+            // Local test (serial command) - nothing to report to the backend
+            Serial.println(event.success ? "✅ Lighting system test passed!" : "❌ Lighting system test failed!");
+        }
+        else if (event.success)
+        {
+            Serial.println("✅ Lighting system test passed!");
+            sendMessage("{\"event\":\"lightingSystemTest\",\"data\":{\"deviceId\":\"" +
+                        event.reference + "\",\"success\":true}}");
+        }
+        else
+        {
+            Serial.println("❌ Lighting system test failed!");
+            sendMessage("{\"event\":\"lightingSystemTest\",\"data\":{\"deviceId\":\"" +
+                        event.reference + "\",\"success\":false,\"error\":\"Connection test failed\"}}");
+        }
+        break;
+
+    case LIGHT_EVENT_READY:
+    case LIGHT_EVENT_STATUS:
+        sendLightingSystemStatus(event.status);
+        break;
+
+    case LIGHT_EVENT_USER_ACTION:
+        handleUserNotification(event.action, event.instructions, event.timeout);
+        break;
+    }
+}
+
+void WSClient::updateLightingJob(const LightEvent &event)
+{
+    Job *job = jobs.findByCommand(event.commandId);
+    if (!job)
+    {
+        return;
+    }
+
+    switch (event.type)
+    {
+    case LIGHT_EVENT_PROGRESS:
+        job->setProgress(event.progress, event.stage);
+        break;
+
+    case LIGHT_EVENT_USER_ACTION:
+        job->setProgress(job->progress, "waitingForUser");
+        break;
+
+    case LIGHT_EVENT_CONFIGURED:
+        event.success ? job->succeed() : job->fail("configuration or authentication failed");
+        break;
+
+    case LIGHT_EVENT_AUTHENTICATED:
+        event.success ? job->succeed() : job->fail("authentication failed");
+        break;
+
+    case LIGHT_EVENT_TESTED:
+        event.success ? job->succeed() : job->fail("connection test failed");
+        break;
+
+    default:
+        break;
+    }
+}
+
+void WSClient::reportJob(const Job &job)
+{
+    bool finished = job.isFinished();
+
+    JsonDocument doc;
+    doc["event"] = finished ? "jobCompleted" : "jobProgress";
+    JsonObject data = doc["data"].to<JsonObject>();
+    data["deviceId"] = deviceManager->getDeviceId();
+    data["jobId"] = job.id;
+    data["type"] = job.type;
+    if (job.requestId.length() > 0)
+    {
+        data["requestId"] = job.requestId;
+    }
+
+    if (finished)
+    {
+        data["success"] = job.state == JOB_SUCCEEDED;
+        data["durationMs"] = millis() - job.startedAt;
+        if (job.error.length() > 0)
+        {
+            data["error"] = job.error;
+        }
+        Serial.printf("🧾 Job %lu (%s) %s\n", (unsigned long)job.id, job.type,
+                      job.state == JOB_SUCCEEDED ? "completed" : ("failed: " + job.error).c_str());
+    }
+    else
+    {
+        data["stage"] = job.stage;
+        data["progress"] = job.progress;
+    }
+
+    queueMessage(doc);
+}
+
 void WSClient::handleUserNotification(const String &action, const String &instructions, int timeout)
 {
     Serial.println("🔔 Handling user notification: " + action);
@@ -679,11 +1243,10 @@ void WSClient::handleUserNotification(const String &action, const String &instru
             notification["data"]["displayMessage"] = "Nanoleaf Authentication Required";
         }
 
-        String message;
-        serializeJson(notification, message);
-
-        Serial.println("📤 Sending user notification to backend: " + message);
-        sendMessage(message);
+        Serial.print("📤 Sending user notification to backend: ");
+        serializeJson(notification, Serial);
+        Serial.println();
+        queueMessage(notification);
     }
     else
     {
@@ -692,53 +1255,32 @@ void WSClient::handleUserNotification(const String &action, const String &instru
     }
 }
 
-void WSClient::displayColorPaletteOnLights()
+uint32_t WSClient::displayColorPaletteOnLights()
 {
-    if (!lightManager || !lightManager->isReady())
+    // Palettes that arrive while the lights start queue behind LIGHT_CMD_BEGIN
+    if (!lightingTask || !lightingTask->acceptsPalettes())
     {
-        Serial.println("⚠ No lighting system available, skipping physical display");
-        return;
+        Serial.println("⚠ No lighting system configured, skipping physical display");
+        return 0;
     }
 
     Serial.println("💡 Displaying palette on physical lighting system...");
 
-    // currentPalette is already in the new ColorPalette format
-    // Display on lights
-    if (lightManager->displayPalette(currentPalette))
+    // The lighting task drives all targets; the result comes back as a
+    // LIGHT_EVENT_PALETTE_DISPLAYED event, so the message loop is never blocked
+    uint32_t commandId = lightingTask->displayPalette(currentPalette);
+    if (commandId == 0)
     {
-        Serial.println("✅ Palette successfully displayed on lights");
+        Serial.println("❌ Failed to queue palette for display");
     }
-    else
-    {
-        Serial.println("❌ Failed to display palette on lights");
-    }
-}
-
-::ColorPalette WSClient::convertToLightPalette(const LegacyColorPalette &legacyPalette)
-{
-    ColorPalette lightPalette;
-
-    // Copy metadata
-    lightPalette.name = "From " + legacyPalette.senderName;
-    lightPalette.messageId = legacyPalette.messageId;
-    lightPalette.senderName = legacyPalette.senderName;
-    lightPalette.colorCount = min(legacyPalette.colorCount, MAX_COLORS);
-
-    // Convert colors from hex strings to RGBColor structs
-    for (int i = 0; i < lightPalette.colorCount; i++)
-    {
-        String hexColor = legacyPalette.colors[i];
-        lightPalette.colors[i] = LightControllerUtils::hexToColor(hexColor);
-    }
-
-    return lightPalette;
+    return commandId;
 }
 
 bool WSClient::retryLightingAuthentication()
 {
-    if (!lightManager)
+    if (!lightingTask)
     {
-        Serial.println("❌ No light manager available");
+        Serial.println("❌ No lighting task available");
         return false;
     }
 
@@ -750,111 +1292,182 @@ bool WSClient::retryLightingAuthentication()
 
     Serial.println("🔄 Retrying lighting system authentication...");
 
-    if (lightManager->authenticateLightingSystem())
+    // Updated status is sent when the LIGHT_EVENT_AUTHENTICATED event arrives
+    uint32_t commandId = lightingTask->authenticate();
+    jobs.track("lightingAuth", "", commandId);
+    return commandId != 0;
+}
+
+void WSClient::sendLightingSystemStatus()
+{
+    if (!isClientConnected() || !lightingTask)
     {
-        Serial.println("✅ Lighting authentication retry successful");
+        Serial.println("⚠ Cannot send lighting status - WebSocket not connected or no lighting task");
+        return;
+    }
 
-        // Send updated status after successful authentication
-        sendLightingSystemStatus();
+    // The snapshot is built on the lighting task and sent from handleLightingEvent()
+    lightingTask->requestStatus();
+}
 
-        return true;
-    }
-    else
+void WSClient::sendLightingSystemStatus(const String &status)
+{
+    if (!isClientConnected())
     {
-        Serial.println("❌ Lighting authentication retry failed");
+        Serial.println("⚠ Cannot send lighting status - WebSocket not connected");
+        return;
+    }
 
-        // Send status update to show failure
-        sendLightingSystemStatus();
+    JsonDocument current;
+    if (deserializeJson(current, status))
+    {
+        Serial.println("❌ Invalid lighting status snapshot");
+        return;
+    }
 
-        return false;
+    JsonDocument doc;
+    if (!buildStatusMessage("lightingSystemStatus", current.as<JsonObjectConst>(), lastLightingStatus, doc))
+    {
+        Serial.println("📊 Lighting status unchanged, nothing to send");
+        return;
     }
+
+    Serial.print("📤 Sending lighting status: ");
+    serializeJson(doc, Serial);
+    Serial.println();
+    queueMessage(doc);
 }
 
-void WSClient::sendLightingSystemStatus()
+void WSClient::sendDeviceStatus()
 {
-    if (!isClientConnected() || !lightManager)
+    if (!isClientConnected())
     {
-        Serial.println("⚠ Cannot send lighting status - WebSocket not connected or no light manager");
+        Serial.println("⚠ Cannot send device status - WebSocket not connected");
         return;
     }
 
-    Serial.println("📊 Sending lighting system status update...");
+    DeviceInfo deviceInfo = deviceManager->getDeviceInfo();
 
-    JsonDocument statusDoc;
-    statusDoc["event"] = "lightingSystemStatus";
-    statusDoc["data"]["deviceId"] = deviceManager->getDeviceId();
-    statusDoc["data"]["timestamp"] = millis();
+    // Only fields that rarely change are diffed against the last report
+    JsonDocument current;
+    current["isOnline"] = true;
+    current["isProvisioned"] = deviceInfo.isProvisioned;
+    current["firmwareVersion"] = deviceInfo.firmwareVersion;
+    current["ipAddress"] = WiFi.localIP().toString();
+    current["macAddress"] = deviceInfo.macAddress;
+    if (bootTimeline && bootTimeline->isComplete())
+    {
+        bootTimeline->report(current["boot"].to<JsonObject>());
+    }
 
-    // Get lighting system status - check if system type is configured
-    String systemType = lightManager->getCurrentSystemType();
-    bool hasLightingSystem = (systemType.length() > 0 && systemType != "none");
+    bool telemetryDue = lastDeviceStatus.isNull() || millis() - lastTelemetryAt >= STATUS_TELEMETRY_INTERVAL;
 
-    if (hasLightingSystem)
+    JsonDocument doc;
+    if (!buildStatusMessage("deviceStatus", current.as<JsonObjectConst>(), lastDeviceStatus, doc, telemetryDue))
     {
-        statusDoc["data"]["hasLightingSystem"] = true;
-        statusDoc["data"]["isReady"] = lightManager->isReady();
-        statusDoc["data"]["systemType"] = systemType;
+        return;
+    }
 
-        // Get status from the controller - if ready, show as connected, otherwise show actual status
-        String statusMessage = lightManager->getStatus();
-        if (lightManager->isReady() && statusMessage == "Disconnected")
-        {
-            statusMessage = "Connected and Ready";
-        }
-        statusDoc["data"]["status"] = statusMessage;
+    if (telemetryDue)
+    {
+        // Built only when sent: the latency percentiles and histograms are not free
+        addTelemetry(doc["data"].as<JsonObject>());
+        lastTelemetryAt = millis();
+    }
 
-        // Get capabilities if available
-        JsonObject capabilities = lightManager->getCapabilities();
-        if (!capabilities.isNull())
+    Serial.print("📤 Sending device status: ");
+    serializeJson(doc, Serial);
+    Serial.println();
+    queueMessage(doc);
+}
+
+void WSClient::addTelemetry(JsonObject data)
+{
+    data["wifiRSSI"] = WiFi.RSSI();
+    data["freeHeap"] = ESP.getFreeHeap();
+    data["uptime"] = millis() / 1000;
+    paletteLatency.report(data["paletteLatency"].to<JsonObject>());
+    JsonObject connection = data["connection"].to<JsonObject>();
+    reconnect.report(connection);
+    pingMonitor.report(connection);
+    if (loopScheduler)
+    {
+        loopScheduler->report(data["loop"].to<JsonObject>());
+    }
+}
+
+bool WSClient::buildStatusMessage(const char *event, JsonObjectConst current, JsonDocument &lastSent, JsonDocument &doc,
+                                  bool force)
+{
+    bool full = lastSent.isNull();
+
+    doc["event"] = event;
+    JsonObject data = doc["data"].to<JsonObject>();
+
+    int changed = 0;
+    for (JsonPairConst field : current)
+    {
+        if (!full && lastSent[field.key()] == field.value())
         {
-            statusDoc["data"]["capabilities"] = capabilities;
+            continue;
         }
+        data[field.key()] = field.value();
+        changed++;
     }
-    else
+
+    if (changed == 0 && !force)
     {
-        statusDoc["data"]["hasLightingSystem"] = false;
-        statusDoc["data"]["isReady"] = false;
-        statusDoc["data"]["systemType"] = "none";
-        statusDoc["data"]["status"] = "No lighting system configured";
+        return false;
     }
 
-    String message;
-    serializeJson(statusDoc, message);
+    // The backend merges deltas into the last full snapshot it received
+    if (!full)
+    {
+        data["delta"] = true;
+    }
+    data["deviceId"] = deviceManager->getDeviceId();
+    data["timestamp"] = millis();
 
-    Serial.println("📤 Sending lighting status: " + message);
-    sendMessage(message);
+    lastSent.set(current);
+    return true;
 }
 
-void WSClient::sendDeviceStatus()
+void WSClient::sendTimeSync()
 {
-    if (!isClientConnected())
-    {
-        Serial.println("⚠ Cannot send device status - WebSocket not connected");
-        return;
-    }
+    // The backend echoes t0 with its clock; see PaletteLatency::applyTimeSync
+    JsonDocument doc;
+    doc["event"] = "timeSync";
+    doc["data"]["deviceId"] = deviceManager->getDeviceId();
+    doc["data"]["t0"] = (uint32_t)millis();
 
-    Serial.println("📊 Sending device status update...");
+    queueMessage(doc);
+}
 
-    DeviceInfo deviceInfo = deviceManager->getDeviceInfo();
+void WSClient::handleRequestStatus(JsonDocument &doc)
+{
+    Serial.println("📊 Backend requested a full status snapshot");
 
-    JsonDocument statusDoc;
-    statusDoc["event"] = "deviceStatus";
-    statusDoc["data"]["deviceId"] = deviceInfo.deviceId;
-    statusDoc["data"]["timestamp"] = millis();
-    statusDoc["data"]["isOnline"] = true;
-    statusDoc["data"]["isProvisioned"] = deviceInfo.isProvisioned;
-    statusDoc["data"]["firmwareVersion"] = deviceInfo.firmwareVersion;
-    statusDoc["data"]["ipAddress"] = WiFi.localIP().toString();
-    statusDoc["data"]["macAddress"] = deviceInfo.macAddress;
-    statusDoc["data"]["wifiRSSI"] = WiFi.RSSI();
-    statusDoc["data"]["freeHeap"] = ESP.getFreeHeap();
-    statusDoc["data"]["uptime"] = millis() / 1000;
+    lastDeviceStatus.clear();
+    lastLightingStatus.clear();
 
-    String message;
-    serializeJson(statusDoc, message);
+    sendDeviceStatus();
+    if (lightingTask)
+    {
+        // Query the controller again instead of reporting the cached status
+        lightingTask->requestStatus(true);
+    }
+}
+
+void WSClient::handleTimeSync(JsonDocument &doc)
+{
+    uint64_t serverTime = doc["data"]["serverTime"].as<uint64_t>();
+    if (serverTime == 0)
+    {
+        Serial.println("⚠ timeSync reply without server time");
+        return;
+    }
 
-    Serial.println("📤 Sending device status: " + message);
-    sendMessage(message);
+    paletteLatency.applyTimeSync(doc["data"]["t0"].as<uint32_t>(), serverTime);
 }
 
 void WSClient::handleFactoryReset(JsonDocument &doc)
@@ -869,22 +1482,32 @@ void WSClient::handleFactoryReset(JsonDocument &doc)
         response["data"]["deviceId"] = deviceManager->getDeviceId();
         response["data"]["timestamp"] = millis();
 
-        String message;
-        serializeJson(response, message);
-        sendMessage(message);
-
+        queueMessage(response);
         Serial.println("📤 Sent factory reset acknowledgment");
     }
 
-    // Give a moment for the message to be sent
-    delay(500);
+    // The acknowledgment leaves at the end of this loop pass; the reset runs
+    // as a job once it had FACTORY_RESET_GRACE to get out, without blocking
+    // the socket in the meantime
+    uint32_t jobId = jobs.start("factoryReset", "", [this](Job &job)
+                                {
+        if (millis() - job.startedAt < FACTORY_RESET_GRACE)
+        {
+            return;
+        }
 
-    // Perform the actual factory reset
-    if (deviceManager)
+        flushOutbound(true);
+        if (deviceManager)
+        {
+            deviceManager->resetDevice();
+        }
+        Serial.println("🔄 Factory reset initiated, device will restart...");
+        job.succeed(); });
+
+    if (jobId == 0 && deviceManager)
     {
+        // No job slot: reset right away rather than ignoring the command
+        flushOutbound(true);
         deviceManager->resetDevice();
     }
-
-    // Reset will restart the device, so this code won't be reached
-    Serial.println("🔄 Factory reset initiated, device will restart...");
 }
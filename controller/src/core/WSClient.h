@@ -3,62 +3,169 @@
 
 #include <ArduinoWebsockets.h>
 #include <ArduinoJson.h>
+#include "BootTimeline.h"
 #include "DeviceManager.h"
-#include "../lighting/LightManager.h"
+#include "JobManager.h"
+#include "JsonArena.h"
+#include "LoopScheduler.h"
+#include "OutboundBatch.h"
+#include "PaletteFrame.h"
+#include "PaletteLatency.h"
+#include "PingMonitor.h"
+#include "ReconnectBackoff.h"
+#include "../lighting/LightingTask.h"
 #include "../config.h"
 
 using namespace websockets;
 
-// Legacy struct for backward compatibility
-struct LegacyColorPalette
-{
-    String messageId;
-    String senderId;
-    String senderName;
-    unsigned long timestamp;
-    String colors[10];
-    int colorCount;
-};
-
 class WSClient
 {
 private:
     WebsocketsClient client;
     DeviceManager *deviceManager;
-    LightManager *lightManager;
+    LightingTask *lightingTask;
     String serverUrl;
     bool isConnected;
+    bool sessionReady; // The backend answered this connection with deviceRegistered or sessionResumed
     unsigned long lastHeartbeat;
-    unsigned long lastConnectionAttempt;
+    ReconnectBackoff reconnect;
+    PingMonitor pingMonitor;
+
+    // Long-running commands, reported as jobProgress/jobCompleted events
+    JobManager jobs;
     ColorPalette currentPalette;
+    bool binaryPalettes; // Backend accepted PALETTE_FRAME_FORMAT in deviceRegistered
+
+    // Inbound event dispatch. Every message is parsed into inboundArena,
+    // keeping only the fields its handler reads, and routed through
+    // eventRoutes by the FNV-1a hash of its event name.
+    typedef void (WSClient::*EventHandler)(JsonDocument &doc);
+
+    struct EventRoute
+    {
+        uint32_t hash;
+        const char *name;
+        EventHandler handler;
+        const char *filter; // ArduinoJson filter listing the fields the handler reads
+    };
+
+    struct EventStats
+    {
+        uint32_t count;
+        uint32_t bytes;
+        uint32_t handlerMicros;
+        uint32_t maxHandlerMicros;
+    };
+
+    static const int EVENT_ROUTE_COUNT = 12;
+    static const EventRoute eventRoutes[EVENT_ROUTE_COUNT];
+
+    JsonArena inboundArena;
+    JsonDocument eventFilter;
+    JsonDocument routeFilters[EVENT_ROUTE_COUNT];
+    EventStats eventStats[EVENT_ROUTE_COUNT];
+    uint32_t unknownEvents;
+
+    // Palette timing: the frame currently being handled and the stage stats
+    unsigned long frameReceivedAt;  // millis()
+    unsigned long frameParseStart; // micros()
+    PaletteLatency paletteLatency;
+
+    // Last status fields sent to the backend; later reports only carry the
+    // fields that changed. Empty after connecting or a requestStatus.
+    // Telemetry that changes on every report is not diffed; it is added to
+    // deviceStatus every STATUS_TELEMETRY_INTERVAL instead.
+    JsonDocument lastDeviceStatus;
+    JsonDocument lastLightingStatus;
+    unsigned long lastTelemetryAt;
+
+    // Outbound messages produced during one loop pass are coalesced into a
+    // single frame and sent by flushOutbound() at the end of the pass
+    struct OutboundStats
+    {
+        uint32_t frames;
+        uint32_t messages;
+        uint32_t bytes;
+        size_t peakBatch;
+        uint32_t failedSends;
+        uint32_t oversized;      // Messages larger than the batch buffer, sent alone
+        uint32_t dropped;
+        uint32_t skippedReports; // Periodic reports skipped while congested
+    };
+
+    OutboundBatch outbound;
+    OutboundStats outboundStats;
+    unsigned long outboundHoldStart;
+    unsigned long outboundHoldMs; // Non-zero while the socket is congested
+
+    // Owned by main.ino; sent once in deviceStatus when the boot completes
+    BootTimeline *bootTimeline;
+    bool bootReported;
+
+    // Owned by main.ino; loop latency goes out in deviceStatus
+    LoopScheduler *loopScheduler;
+
+    // Set while the HTTP registration is still in flight; connect() then
+    // only opens the socket and registration waits for releaseRegistration()
+    bool registrationHeld;
+    bool registrationRejected; // Backend answered registerDevice with registrationError
+
+    bool queueMessage(const JsonDocument &doc);
+    bool queueMessage(const char *json, size_t length);
+    void holdOutbound(unsigned long ms);
+    bool isOutboundHeld();
+    void resetOutbound();
+
+    void buildInboundFilters();
+    int findEventRoute(const char *event);
 
     // Message handlers
     void handleColorPalette(JsonDocument &doc);
+    void handleBinaryFrame(const uint8_t *data, size_t length);
     void handleDeviceRegistered(JsonDocument &doc);
     void handleDeviceClaimed(JsonDocument &doc);
     void handleSetupComplete(JsonDocument &doc);
     void handleLightingSystemConfig(JsonDocument &doc);
     void handleTestLightingSystem(JsonDocument &doc);
     void handleFactoryReset(JsonDocument &doc);
+    void handleTimeSync(JsonDocument &doc);
+    void handleRequestStatus(JsonDocument &doc);
+    void handleSessionResumed(JsonDocument &doc);
+    void handleSessionRejected(JsonDocument &doc);
+    void handleRegistrationError(JsonDocument &doc);
 
     // Connection management
-    void onMessageCallback(WebsocketsMessage message);
+    void onMessageCallback(const WebsocketsMessage &message);
     void onEventsCallback(WebsocketsEvent event, String data);
+    void sendPing();
+    void handlePong(const String &payload);
+    void checkConnectionHealth();
 
     // User notification handling
     void handleUserNotification(const String &action, const String &instructions, int timeout);
 
+    // Lighting task completion events
+    void processLightingEvents();
+    void handleLightingEvent(const LightEvent &event);
+    void updateLightingJob(const LightEvent &event);
+    void reportJob(const Job &job);
+
     // Status reporting
     void sendLightingSystemStatus();
+    void sendLightingSystemStatus(const String &status);
     void sendDeviceStatus();
+    void sendTimeSync();
+    bool buildStatusMessage(const char *event, JsonObjectConst current, JsonDocument &lastSent, JsonDocument &doc,
+                            bool force = false);
+    void addTelemetry(JsonObject data);
 
     // Utility functions
+    void showReceivedPalette(uint32_t parseMicros, uint64_t createdAt, uint64_t sentAt);
     void displayColorPaletteSerial();
-    void displayColorPaletteOnLights();
-    ColorPalette convertToLightPalette(const LegacyColorPalette &legacyPalette);
+    uint32_t displayColorPaletteOnLights();
 
 public:
-    WSClient(DeviceManager *devManager, LightManager *lightMgr = nullptr);
+    WSClient(DeviceManager *devManager, LightingTask *lightTask = nullptr);
 
     void begin(const String &url);
     bool connect();
@@ -66,18 +173,74 @@ public:
     bool isClientConnected();
     void loop();
     void sendHeartbeat();
+
+    /**
+     * Queue the periodic deviceStatus (a delta against the last report).
+     * Skipped while the socket is congested.
+     * @return false when the socket is down and the caller should use HTTP
+     */
+    bool sendPeriodicStatus();
     bool registerDevice();
+
+    /**
+     * Present the session token from the last registration instead of
+     * registering again. Falls back to registerDevice() if the backend
+     * rejects it.
+     * @return false when there is no session to resume
+     */
+    bool resumeSession();
     void sendMessage(const String &message);
 
+    /**
+     * Send every queued message as one frame
+     * @param force Send even while the socket is marked congested
+     * @return true when nothing is left queued
+     */
+    bool flushOutbound(bool force = false);
+
+    // True while sends are slow or failing, or the batch is nearly full;
+    // optional traffic such as periodic reports should wait
+    bool isOutboundCongested();
+
     // Light management
-    void setLightManager(LightManager *lightMgr);
+    void setLightingTask(LightingTask *lightTask);
+
+    void setBootTimeline(BootTimeline *timeline) { bootTimeline = timeline; }
+    void setLoopScheduler(LoopScheduler *scheduler) { loopScheduler = scheduler; }
+
+    /**
+     * Open the socket without registering, so the handshake overlaps the
+     * HTTP registration. releaseRegistration() sends registerDevice (or
+     * resumeSession) once the HTTP result is in.
+     */
+    void holdRegistration() { registrationHeld = true; }
+    void releaseRegistration();
+
+    // The backend accepted this connection's registration or session resume
+    bool isSessionReady() const { return isConnected && sessionReady; }
+
+    // The backend refused the WebSocket registration; the device has to
+    // register over HTTP again
+    bool isRegistrationRejected() const { return registrationRejected; }
 
     // Manual lighting authentication retry (for when initial authentication fails)
+    // Returns true when the retry was queued; the result arrives as a lighting event
     bool retryLightingAuthentication();
 
+    // Per-event dispatch, outbound batching and connection counters
+    void printEventStats();
+
+    /**
+     * FNV-1a hash of an event name, usable at compile time
+     */
+    static constexpr uint32_t eventHash(const char *name, uint32_t hash = 2166136261u)
+    {
+        return *name ? eventHash(name + 1, (hash ^ (uint8_t)*name) * 16777619u) : hash;
+    }
+
     // Status helpers
     bool shouldSendHeartbeat();
-    bool shouldRetryConnection();
+    bool shouldRetryConnection(); // Reconnect backoff has elapsed
 };
 
 #endif
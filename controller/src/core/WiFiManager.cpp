@@ -1,8 +1,14 @@
 #include "WiFiManager.h"
 #include <ArduinoJson.h>
 
-WiFiManager::WiFiManager() : server(nullptr), dnsServer(nullptr), isAPMode(false), apStartTime(0)
+WiFiManager::WiFiManager()
+    : server(nullptr), dnsServer(nullptr), isAPMode(false), apStartTime(0), restartAt(0), connectionState(WIFI_STATE_IDLE),
+      attemptStartedAt(0), retryAt(0), consecutiveFailures(0), lastDisconnectReason(0), gotIpPending(false),
+      disconnectPending(false), pendingDisconnectReason(0), hasConnectCache(false), attemptIsFast(false),
+      fastConnectFailed(false), hasLease(false), staticIpApplied(false), lastConnectMs(0), lastConnectWasFast(false)
 {
+    memset(&connectCache, 0, sizeof(connectCache));
+    memset(&lease, 0, sizeof(lease));
 }
 
 WiFiManager::~WiFiManager()
@@ -24,6 +30,10 @@ void WiFiManager::begin()
     // Load saved credentials
     savedSSID = preferences.getString(PREF_WIFI_SSID, "");
     savedPassword = preferences.getString(PREF_WIFI_PASSWORD, "");
+    loadConnectCache();
+
+    WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info)
+                 { onWiFiEvent(event, info); });
 
     Serial.println("📶 WiFiManager initialized");
     if (savedSSID.length() > 0)
@@ -36,7 +46,7 @@ void WiFiManager::begin()
     }
 }
 
-bool WiFiManager::connectToWiFi()
+bool WiFiManager::beginConnect()
 {
     if (savedSSID.length() == 0)
     {
@@ -44,32 +54,269 @@ bool WiFiManager::connectToWiFi()
         return false;
     }
 
-    Serial.println("📶 Attempting to connect to WiFi: " + savedSSID);
+    if (connectionState != WIFI_STATE_IDLE)
+    {
+        return true;
+    }
+
     WiFi.mode(WIFI_STA);
-    WiFi.begin(savedSSID.c_str(), savedPassword.c_str());
+    WiFi.setAutoReconnect(false);
+    consecutiveFailures = 0;
+    fastConnectFailed = false;
+    startAttempt();
+    return true;
+}
+
+void WiFiManager::startAttempt()
+{
+    // Drop events left over from the previous attempt
+    gotIpPending = false;
+    disconnectPending = false;
 
-    unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - startTime < WIFI_CONNECT_TIMEOUT)
+    attemptIsFast = hasConnectCache && !fastConnectFailed;
+    staticIpApplied = attemptIsFast && WIFI_FAST_CONNECT_STATIC_IP && isLeaseValid();
+    if (staticIpApplied)
+    {
+        WiFi.config(IPAddress(lease.ip), IPAddress(lease.gateway), IPAddress(lease.subnet), IPAddress(lease.dns));
+    }
+    else
     {
-        delay(500);
-        Serial.print(".");
+        // Back to DHCP in case an earlier attempt applied the lease
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
     }
-    Serial.println();
 
-    if (WiFi.status() == WL_CONNECTED)
+    if (attemptIsFast)
     {
-        Serial.println("✅ WiFi connected successfully!");
-        Serial.println("📍 IP Address: " + WiFi.localIP().toString());
-        Serial.println("📡 Signal Strength: " + String(WiFi.RSSI()) + " dBm");
-        return true;
+        Serial.printf("⚡ Fast WiFi connect to %s (channel %u, cached BSSID%s)\n", savedSSID.c_str(),
+                      connectCache.channel, staticIpApplied ? ", reusing lease" : "");
+        WiFi.begin(savedSSID.c_str(), savedPassword.c_str(), connectCache.channel, connectCache.bssid);
     }
     else
     {
-        Serial.println("❌ WiFi connection failed");
-        return false;
+        Serial.println("📶 Attempting to connect to WiFi: " + savedSSID);
+        WiFi.begin(savedSSID.c_str(), savedPassword.c_str());
+    }
+
+    connectionState = WIFI_STATE_CONNECTING;
+    attemptStartedAt = millis();
+}
+
+void WiFiManager::scheduleRetry(const char *reason)
+{
+    if (attemptIsFast)
+    {
+        // The access point moved or the lease is gone: scan right away
+        Serial.printf("⚠ Fast WiFi connect failed (%s), falling back to a full scan\n", reason);
+        fastConnectFailed = true;
+        WiFi.disconnect();
+        startAttempt();
+        return;
+    }
+
+    consecutiveFailures++;
+
+    unsigned long delayMs = WIFI_RECONNECT_DELAY_BASE;
+    for (int i = 1; i < consecutiveFailures && delayMs < WIFI_RECONNECT_DELAY_MAX; i++)
+    {
+        delayMs *= 2;
+    }
+    delayMs = min(delayMs, (unsigned long)WIFI_RECONNECT_DELAY_MAX);
+
+    connectionState = WIFI_STATE_RECONNECT_WAIT;
+    retryAt = millis() + delayMs;
+
+    Serial.printf("⏳ WiFi %s, retrying in %lu ms (failure %d)\n", reason, delayMs, consecutiveFailures);
+}
+
+void WiFiManager::onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info)
+{
+    // WiFi event task: only record the event, loop() acts on it
+    switch (event)
+    {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+        gotIpPending = true;
+        break;
+
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        pendingDisconnectReason = info.wifi_sta_disconnected.reason;
+        disconnectPending = true;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void WiFiManager::processConnectionEvents()
+{
+    if (connectionState == WIFI_STATE_IDLE)
+    {
+        gotIpPending = false;
+        disconnectPending = false;
+        return;
+    }
+
+    // A drop is handled before a new IP so a quick drop-and-recover still
+    // reaches the listener as a disconnect followed by a connect
+    if (disconnectPending)
+    {
+        disconnectPending = false;
+        lastDisconnectReason = pendingDisconnectReason;
+
+        if (connectionState == WIFI_STATE_CONNECTED)
+        {
+            Serial.println("⚠ WiFi connection lost (reason " + String(lastDisconnectReason) + ")");
+            consecutiveFailures = 0;
+            attemptIsFast = false; // The cached association is still worth retrying after the delay
+            scheduleRetry("link lost");
+            if (listener)
+            {
+                listener(false);
+            }
+        }
+        else if (connectionState == WIFI_STATE_CONNECTING && !gotIpPending &&
+                 lastDisconnectReason != WIFI_REASON_ASSOC_LEAVE)
+        {
+            // ASSOC_LEAVE is our own disconnect (WiFi.begin() drops the previous
+            // attempt), not a verdict on this one
+            scheduleRetry("association failed");
+        }
+    }
+
+    if (gotIpPending)
+    {
+        gotIpPending = false;
+        if (connectionState != WIFI_STATE_CONNECTED && WiFi.status() == WL_CONNECTED)
+        {
+            connectionState = WIFI_STATE_CONNECTED;
+            consecutiveFailures = 0;
+            lastConnectMs = millis() - attemptStartedAt;
+            lastConnectWasFast = attemptIsFast;
+            storeConnectCache(lastConnectMs);
+            fastConnectFailed = false;
+
+            Serial.println("✅ WiFi connected successfully!");
+            Serial.println("📍 IP Address: " + WiFi.localIP().toString());
+            Serial.println("📡 Signal Strength: " + String(WiFi.RSSI()) + " dBm");
+            if (lastConnectWasFast && getFastConnectSavingMs() != 0)
+            {
+                Serial.printf("⚡ Associated in %lu ms, %ld ms faster than the last full scan\n", lastConnectMs,
+                              getFastConnectSavingMs());
+            }
+            else
+            {
+                Serial.printf("⏱ Associated in %lu ms\n", lastConnectMs);
+            }
+
+            if (listener)
+            {
+                listener(true);
+            }
+        }
+    }
+
+    unsigned long attemptTimeout = attemptIsFast ? WIFI_FAST_CONNECT_TIMEOUT : WIFI_CONNECT_TIMEOUT;
+    if (connectionState == WIFI_STATE_CONNECTING && millis() - attemptStartedAt > attemptTimeout)
+    {
+        WiFi.disconnect();
+        scheduleRetry("connection timed out");
+    }
+    else if (connectionState == WIFI_STATE_RECONNECT_WAIT && (long)(millis() - retryAt) >= 0)
+    {
+        startAttempt();
+    }
+}
+
+void WiFiManager::loadConnectCache()
+{
+    hasConnectCache = preferences.getBytesLength(PREF_WIFI_CONNECT_CACHE) == sizeof(connectCache) &&
+                      preferences.getBytes(PREF_WIFI_CONNECT_CACHE, &connectCache, sizeof(connectCache)) ==
+                          sizeof(connectCache) &&
+                      connectCache.version == WIFI_CONNECT_CACHE_VERSION && connectCache.channel != 0;
+    if (!hasConnectCache)
+    {
+        memset(&connectCache, 0, sizeof(connectCache));
     }
 }
 
+void WiFiManager::storeConnectCache(unsigned long connectMs)
+{
+    const uint8_t *bssid = WiFi.BSSID();
+    if (!bssid)
+    {
+        return;
+    }
+
+    // An address we configured ourselves says nothing about the DHCP server,
+    // so only a DHCP connect starts a new lease
+    if (!staticIpApplied)
+    {
+        lease.ip = WiFi.localIP();
+        lease.gateway = WiFi.gatewayIP();
+        lease.subnet = WiFi.subnetMask();
+        lease.dns = WiFi.dnsIP();
+        lease.obtainedAt = millis();
+        hasLease = lease.ip != 0;
+    }
+
+    WiFiConnectCache updated = connectCache;
+    updated.version = WIFI_CONNECT_CACHE_VERSION;
+    memcpy(updated.bssid, bssid, sizeof(updated.bssid));
+    updated.channel = WiFi.channel();
+    if (!attemptIsFast)
+    {
+        updated.scanConnectMs = connectMs;
+    }
+
+    // Only touch flash when something changed
+    if (hasConnectCache && memcmp(&updated, &connectCache, sizeof(updated)) == 0)
+    {
+        return;
+    }
+
+    connectCache = updated;
+    hasConnectCache = true;
+    preferences.putBytes(PREF_WIFI_CONNECT_CACHE, &connectCache, sizeof(connectCache));
+}
+
+void WiFiManager::clearConnectCache()
+{
+    preferences.remove(PREF_WIFI_CONNECT_CACHE);
+    memset(&connectCache, 0, sizeof(connectCache));
+    hasConnectCache = false;
+    hasLease = false;
+}
+
+bool WiFiManager::isLeaseValid() const
+{
+    return hasLease && millis() - lease.obtainedAt < WIFI_FAST_CONNECT_LEASE_TIME;
+}
+
+long WiFiManager::getFastConnectSavingMs() const
+{
+    if (!lastConnectWasFast || connectCache.scanConnectMs == 0)
+    {
+        return 0;
+    }
+    return (long)connectCache.scanConnectMs - (long)lastConnectMs;
+}
+
+const char *WiFiManager::getConnectionStateName() const
+{
+    switch (connectionState)
+    {
+    case WIFI_STATE_IDLE:
+        return "idle";
+    case WIFI_STATE_CONNECTING:
+        return "connecting";
+    case WIFI_STATE_CONNECTED:
+        return "connected";
+    case WIFI_STATE_RECONNECT_WAIT:
+        return "waiting to retry";
+    }
+    return "unknown";
+}
+
 void WiFiManager::startAPMode()
 {
     if (isAPMode)
@@ -85,6 +332,8 @@ void WiFiManager::startAPMode()
     macAddr.replace(":", "");
     String apSSID = String(DEFAULT_AP_SSID) + "-" + macAddr.substring(6);
 
+    // The portal replaces any station connection attempt
+    connectionState = WIFI_STATE_IDLE;
     WiFi.mode(WIFI_AP);
     bool apStarted = WiFi.softAP(apSSID.c_str(), DEFAULT_AP_PASSWORD);
 
@@ -206,8 +455,7 @@ void WiFiManager::handleSave(AsyncWebServerRequest *request)
                       "<p>Configure your lighting system through the PalPalette mobile app after pairing.</p>"
                       "<p>You can close this window.</p></body></html>");
 
-        delay(2000);
-        ESP.restart();
+        scheduleRestart();
     }
     else
     {
@@ -240,8 +488,18 @@ void WiFiManager::handleReset(AsyncWebServerRequest *request)
                   "<html><body><h1>Device Reset</h1>"
                   "<p>All settings cleared. Device will restart.</p></body></html>");
 
-    delay(2000);
-    ESP.restart();
+    scheduleRestart();
+}
+
+void WiFiManager::scheduleRestart()
+{
+    // Portal handlers run on the AsyncTCP task, which has to be free to send
+    // the reply; loop() restarts once it is out
+    restartAt = millis() + CAPTIVE_PORTAL_RESTART_DELAY;
+    if (restartAt == 0)
+    {
+        restartAt = 1;
+    }
 }
 
 String WiFiManager::getSetupPageHTML()
@@ -310,7 +568,7 @@ String WiFiManager::getSetupPageHTML()
 
 bool WiFiManager::isConnected()
 {
-    return WiFi.status() == WL_CONNECTED;
+    return connectionState == WIFI_STATE_CONNECTED;
 }
 
 bool WiFiManager::isInAPMode()
@@ -324,6 +582,7 @@ void WiFiManager::saveWiFiCredentials(const String &ssid, const String &password
     preferences.putString(PREF_WIFI_PASSWORD, password);
     savedSSID = ssid;
     savedPassword = password;
+    clearConnectCache();
 
     Serial.println("💾 WiFi credentials saved for: " + ssid);
 }
@@ -364,6 +623,7 @@ void WiFiManager::clearWiFiCredentials()
     preferences.remove(PREF_SERVER_URL);
     preferences.remove(PREF_DEVICE_ID);
     preferences.remove(PREF_IS_PROVISIONED);
+    clearConnectCache();
 
     savedSSID = "";
     savedPassword = "";
@@ -396,6 +656,14 @@ String WiFiManager::getMacAddress()
 
 void WiFiManager::loop()
 {
+    processConnectionEvents();
+
+    if (restartAt != 0 && (long)(millis() - restartAt) >= 0)
+    {
+        Serial.println("🔄 Restarting to apply the portal settings...");
+        ESP.restart();
+    }
+
     if (isAPMode && dnsServer)
     {
         dnsServer->processNextRequest();
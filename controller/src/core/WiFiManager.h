@@ -6,8 +6,62 @@
 #include <ESPAsyncWebServer.h>
 #include <DNSServer.h>
 #include <Preferences.h>
+#include <functional>
 #include "../config.h"
 
+enum WiFiConnectionState
+{
+    WIFI_STATE_IDLE,          // No station connection requested (setup or AP mode)
+    WIFI_STATE_CONNECTING,    // WiFi.begin() issued, waiting for an IP
+    WIFI_STATE_CONNECTED,     // Associated and holding an IP
+    WIFI_STATE_RECONNECT_WAIT // Attempt failed or link dropped, next attempt scheduled
+};
+
+/**
+ * Last good association, stored in NVS as one blob so a reboot after a
+ * power cut can skip the scan
+ */
+struct WiFiConnectCache
+{
+    uint8_t version;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t scanConnectMs; // Association time of the last full scan connect, 0 if unknown
+};
+
+/**
+ * Address handed out by DHCP during this boot. Kept in RAM only: with no
+ * clock across reboots the age of a stored lease cannot be known.
+ */
+struct WiFiLease
+{
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    unsigned long obtainedAt; // millis() of the DHCP connect
+};
+
+// Called from loop() when the station link comes up (true) or goes down (false)
+typedef std::function<void(bool connected)> WiFiConnectionListener;
+
+/**
+ * WiFi station and captive portal management
+ *
+ * Connecting never blocks: beginConnect() issues WiFi.begin() once and the
+ * ESP32 WiFi events report the outcome. The event handler runs on the WiFi
+ * event task and only records what happened; loop() applies it on the main
+ * task, notifies the listener and retries failed or dropped links with
+ * exponential backoff. The core's own auto-reconnect is turned off so only
+ * this state machine calls WiFi.begin().
+ *
+ * When a previous association is cached, the first attempt is directed at
+ * the cached BSSID and channel with the short WIFI_FAST_CONNECT_TIMEOUT. If
+ * it fails, the next attempt is a normal scan and DHCP connect right away.
+ * With WIFI_FAST_CONNECT_STATIC_IP set, a reconnect within
+ * WIFI_FAST_CONNECT_LEASE_TIME of the last DHCP connect also skips DHCP by
+ * applying that lease statically; only DHCP connects refresh the lease.
+ */
 class WiFiManager
 {
 private:
@@ -18,8 +72,41 @@ private:
     String savedPassword;
     bool isAPMode;
     unsigned long apStartTime;
+    volatile unsigned long restartAt; // Set by portal handlers on the AsyncTCP task: millis() of the restart, 0 if none
+
+    WiFiConnectionState connectionState;
+    WiFiConnectionListener listener;
+    unsigned long attemptStartedAt;
+    unsigned long retryAt;
+    int consecutiveFailures;
+    uint8_t lastDisconnectReason;
+
+    // Written by the WiFi event task, consumed by loop()
+    volatile bool gotIpPending;
+    volatile bool disconnectPending;
+    volatile uint8_t pendingDisconnectReason;
+
+    WiFiConnectCache connectCache;
+    bool hasConnectCache;
+    bool attemptIsFast;
+    bool fastConnectFailed;
+    WiFiLease lease;
+    bool hasLease;
+    bool staticIpApplied; // The current attempt reuses the lease instead of DHCP
+    unsigned long lastConnectMs;
+    bool lastConnectWasFast;
+
+    void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info);
+    void processConnectionEvents();
+    void startAttempt();
+    void scheduleRetry(const char *reason);
+    void loadConnectCache();
+    void storeConnectCache(unsigned long connectMs);
+    void clearConnectCache();
+    bool isLeaseValid() const;
 
     void setupCaptivePortal();
+    void scheduleRestart();
     void handleRoot(AsyncWebServerRequest *request);
     void handleSave(AsyncWebServerRequest *request);
     void handleStatus(AsyncWebServerRequest *request);
@@ -31,7 +118,29 @@ public:
     ~WiFiManager();
 
     void begin();
-    bool connectToWiFi();
+
+    /**
+     * Start connecting to the stored network; returns immediately.
+     * Outcome arrives through the listener and getConnectionState().
+     * @return false when no credentials are stored
+     */
+    bool beginConnect();
+    void setConnectionListener(WiFiConnectionListener connectionListener) { listener = connectionListener; }
+    WiFiConnectionState getConnectionState() const { return connectionState; }
+    const char *getConnectionStateName() const;
+    int getConsecutiveFailures() const { return consecutiveFailures; }
+    uint8_t getLastDisconnectReason() const { return lastDisconnectReason; }
+
+    // Association time (WiFi.begin() to IP) of the last successful attempt
+    unsigned long getLastConnectMs() const { return lastConnectMs; }
+    bool wasLastConnectFast() const { return lastConnectWasFast; }
+
+    /**
+     * Time the last fast connect saved compared to the last full scan
+     * connect, or 0 when either is unknown
+     */
+    long getFastConnectSavingMs() const;
+
     void startAPMode();
     void stopAPMode();
     bool isConnected();
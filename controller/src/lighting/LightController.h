@@ -4,9 +4,13 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <functional>
+#include "../core/HttpTransport.h"
 
 // Constants
 #define MAX_COLORS 10
+#define PALETTE_ID_LENGTH 36        // UUID
+#define PALETTE_NAME_LENGTH 40
+#define PALETTE_ANIMATION_LENGTH 12
 
 /**
  * Color structure for RGB values
@@ -23,17 +27,59 @@ struct RGBColor
     // Convert from hex string
     static RGBColor fromHex(const String &hexColor)
     {
-        String hex = hexColor;
-        if (hex.startsWith("#"))
+        RGBColor color;
+        parseHex(hexColor.c_str(), color);
+        return color;
+    }
+
+    /**
+     * Parse "#RRGGBB" or "RRGGBB" in place, without temporary Strings
+     * @return false (and leaves out untouched) if the input is not a 6-digit hex color
+     */
+    static bool parseHex(const char *hex, RGBColor &out)
+    {
+        if (hex == nullptr)
+        {
+            return false;
+        }
+
+        if (*hex == '#')
+        {
+            hex++;
+        }
+
+        uint8_t bytes[3];
+        for (int i = 0; i < 3; i++)
+        {
+            int high = hexDigit(hex[i * 2]);
+            int low = high < 0 ? -1 : hexDigit(hex[i * 2 + 1]);
+            if (low < 0)
+            {
+                return false;
+            }
+            bytes[i] = (uint8_t)((high << 4) | low);
+        }
+
+        if (hex[6] != '\0')
         {
-            hex = hex.substring(1);
+            return false;
         }
 
-        long rgb = strtol(hex.c_str(), NULL, 16);
-        return RGBColor(
-            (rgb >> 16) & 0xFF,
-            (rgb >> 8) & 0xFF,
-            rgb & 0xFF);
+        out.r = bytes[0];
+        out.g = bytes[1];
+        out.b = bytes[2];
+        return true;
+    }
+
+    static int hexDigit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
     }
 
     // Convert to hex string
@@ -47,18 +93,34 @@ struct RGBColor
 
 /**
  * Color palette structure
+ * Metadata lives in fixed-size buffers so palettes can be decoded, copied
+ * and queued without touching the heap.
  */
 struct ColorPalette
 {
-    RGBColor colors[10]; // Maximum 10 colors
+    RGBColor colors[MAX_COLORS];
     int colorCount;
-    String name;
-    String messageId;
-    String senderName;
-    int duration;     // Display duration in milliseconds
-    String animation; // Animation type (fade, pulse, static, etc.)
+    char name[PALETTE_NAME_LENGTH + 1];
+    char messageId[PALETTE_ID_LENGTH + 1];
+    char senderName[PALETTE_NAME_LENGTH + 1];
+    int duration;                                 // Display duration in milliseconds
+    char animation[PALETTE_ANIMATION_LENGTH + 1]; // Animation type (fade, pulse, static, etc.)
+
+    ColorPalette() : colorCount(0), duration(5000)
+    {
+        name[0] = '\0';
+        messageId[0] = '\0';
+        senderName[0] = '\0';
+        setAnimation("fade");
+    }
 
-    ColorPalette() : colorCount(0), duration(5000), animation("fade") {}
+    // Setters truncate to the buffer size
+    void setName(const char *value) { strlcpy(name, value ? value : "", sizeof(name)); }
+    void setMessageId(const char *value) { strlcpy(messageId, value ? value : "", sizeof(messageId)); }
+    void setSenderName(const char *value) { strlcpy(senderName, value ? value : "", sizeof(senderName)); }
+    void setAnimation(const char *value) { strlcpy(animation, value ? value : "", sizeof(animation)); }
+
+    bool hasAnimation(const char *type) const { return strcmp(animation, type) == 0; }
 };
 
 /**
@@ -70,9 +132,15 @@ struct LightConfig
     String hostAddress;      // IP address or hostname
     int port;                // Port number
     String authToken;        // Authentication token
-    JsonObject customConfig; // System-specific configuration
+    JsonDocument customConfig; // System-specific configuration, owned so every copy of the config stays valid
 };
 
+/**
+ * Completion callback for asynchronous palette display
+ * Receives true if the lighting system accepted the palette
+ */
+typedef std::function<void(bool)> DisplayCallback;
+
 /**
  * Abstract base class for all light controllers
  * This defines the interface that all lighting systems must implement
@@ -102,6 +170,54 @@ public:
      */
     virtual bool displayPalette(const ColorPalette &palette) = 0;
 
+    /**
+     * Display a color palette without blocking the caller
+     * Network controllers override this to issue the request through the
+     * shared HttpTransport; the default runs displayPalette() inline.
+     * @param palette The color palette to display
+     * @param callback Invoked once with the result (from HttpTransport::loop() for network controllers)
+     */
+    virtual void displayPaletteAsync(const ColorPalette &palette, DisplayCallback callback)
+    {
+        bool success = displayPalette(palette);
+        if (callback)
+        {
+            callback(success);
+        }
+    }
+
+    /**
+     * Lightweight reachability check used by the background health probe
+     * Network controllers override this with a short asynchronous request;
+     * the default runs testConnection() inline.
+     * @param callback Invoked once with true if the light answered
+     */
+    virtual void probeAsync(DisplayCallback callback)
+    {
+        bool reachable = testConnection();
+        if (callback)
+        {
+            callback(reachable);
+        }
+    }
+
+    /**
+     * Bring a controller whose initialize() did not complete back into service
+     * Called once the health probe sees the light again. Network controllers
+     * override this to redo their setup through the shared HttpTransport; the
+     * default runs initialize() inline.
+     * @param config Configuration the controller was created with
+     * @param callback Invoked once with true if the controller is ready again
+     */
+    virtual void restoreAsync(const LightConfig &config, DisplayCallback callback)
+    {
+        bool restored = initialize(config) && isReady();
+        if (callback)
+        {
+            callback(restored);
+        }
+    }
+
     /**
      * Turn off all lights
      * @return true if successful
@@ -148,10 +264,10 @@ public:
     virtual LightConfig getUpdatedConfig() { return config; }
 
     /**
-     * Get system capabilities (number of lights, supported features, etc.)
-     * @return JSON object describing capabilities
+     * Describe system capabilities (number of lights, supported features, etc.)
+     * @param caps Object owned by the caller to fill in
      */
-    virtual JsonObject getCapabilities() = 0;
+    virtual void getCapabilities(JsonObject caps) = 0;
 
     /**
      * Check if the controller is ready for operations
@@ -172,10 +288,20 @@ public:
         // Default implementation - controllers can override if they support notifications
     }
 
+    /**
+     * Set the HTTP transport used by network-based controllers
+     * @param httpTransport Shared transport owned by the application
+     */
+    void setHttpTransport(HttpTransport *httpTransport)
+    {
+        transport = httpTransport;
+    }
+
 protected:
     LightConfig config;
     bool isInitialized = false;
     bool isAuthenticated = false;
+    HttpTransport *transport = nullptr;
 
     /**
      * Utility function to convert color palette to system-specific format
@@ -255,28 +381,9 @@ public:
      */
     static RGBColor hexToColor(const String &hexColor)
     {
+        // Default to black if invalid
         RGBColor color;
-        String hex = hexColor;
-
-        // Remove # if present
-        if (hex.startsWith("#"))
-        {
-            hex = hex.substring(1);
-        }
-
-        // Ensure we have 6 characters
-        if (hex.length() == 6)
-        {
-            color.r = strtol(hex.substring(0, 2).c_str(), NULL, 16);
-            color.g = strtol(hex.substring(2, 4).c_str(), NULL, 16);
-            color.b = strtol(hex.substring(4, 6).c_str(), NULL, 16);
-        }
-        else
-        {
-            // Default to black if invalid
-            color.r = color.g = color.b = 0;
-        }
-
+        RGBColor::parseHex(hexColor.c_str(), color);
         return color;
     }
 
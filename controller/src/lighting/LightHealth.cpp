@@ -0,0 +1,95 @@
+#include "LightHealth.h"
+
+uint32_t LightHealth::nextEpoch = 0;
+
+LightHealth::LightHealth()
+{
+    reset();
+}
+
+void LightHealth::reset()
+{
+    state = CLOSED;
+    consecutiveFailures = 0;
+    backoffMs = LIGHT_HEALTH_BACKOFF_BASE;
+    nextProbeAt = 0;
+    lastLatencyMs = 0;
+    epoch = ++nextEpoch;
+}
+
+void LightHealth::recordSuccess(unsigned long latencyMs)
+{
+    if (state != CLOSED)
+    {
+        Serial.println("🟢 Lighting target recovered - circuit closed");
+    }
+
+    state = CLOSED;
+    consecutiveFailures = 0;
+    backoffMs = LIGHT_HEALTH_BACKOFF_BASE;
+    lastLatencyMs = latencyMs;
+}
+
+void LightHealth::recordFailure()
+{
+    consecutiveFailures++;
+
+    if (state == CLOSED && consecutiveFailures >= LIGHT_HEALTH_FAILURE_THRESHOLD)
+    {
+        open();
+    }
+}
+
+void LightHealth::trip()
+{
+    consecutiveFailures = max(consecutiveFailures, LIGHT_HEALTH_FAILURE_THRESHOLD);
+    open();
+}
+
+bool LightHealth::probeDue() const
+{
+    return state == OPEN && (long)(millis() - nextProbeAt) >= 0;
+}
+
+void LightHealth::beginProbe()
+{
+    state = HALF_OPEN;
+}
+
+void LightHealth::probeFailed()
+{
+    backoffMs = min(backoffMs * 2, (unsigned long)LIGHT_HEALTH_BACKOFF_MAX);
+    open();
+}
+
+const char *LightHealth::getStateName() const
+{
+    switch (state)
+    {
+    case CLOSED:
+        return "closed";
+    case OPEN:
+        return "open";
+    case HALF_OPEN:
+        return "half-open";
+    }
+    return "unknown";
+}
+
+unsigned long LightHealth::getRetryInMs() const
+{
+    if (state != OPEN)
+    {
+        return 0;
+    }
+
+    long remaining = (long)(nextProbeAt - millis());
+    return remaining > 0 ? remaining : 0;
+}
+
+void LightHealth::open()
+{
+    state = OPEN;
+    nextProbeAt = millis() + backoffMs;
+    Serial.println("🔴 Lighting target unreachable - circuit open, next probe in " + String(backoffMs / 1000) + "s");
+}
@@ -0,0 +1,82 @@
+#ifndef LIGHT_HEALTH_H
+#define LIGHT_HEALTH_H
+
+#include <Arduino.h>
+#include "../config.h"
+
+/**
+ * Health tracker and circuit breaker for one lighting target
+ *
+ * CLOSED:    requests flow normally; consecutive failures are counted.
+ * OPEN:      the target is considered down and requests fail fast. A probe
+ *            becomes due after the current backoff, which doubles after
+ *            every failed probe up to LIGHT_HEALTH_BACKOFF_MAX.
+ * HALF_OPEN: a probe is in flight; its result closes or re-opens the circuit.
+ */
+class LightHealth
+{
+public:
+    enum State
+    {
+        CLOSED,
+        OPEN,
+        HALF_OPEN
+    };
+
+    LightHealth();
+
+    /**
+     * Forget all history (new controller or configuration).
+     * Assigns a new epoch so results of older requests are ignored.
+     */
+    void reset();
+
+    /**
+     * Whether a regular request may be sent to the target
+     */
+    bool allowRequest() const { return state == CLOSED; }
+
+    void recordSuccess(unsigned long latencyMs);
+    void recordFailure();
+
+    /**
+     * Open the circuit immediately (e.g. initialization failed)
+     */
+    void trip();
+
+    /**
+     * Whether the circuit is open and the backoff has elapsed
+     */
+    bool probeDue() const;
+
+    /**
+     * Mark a probe as in flight (OPEN -> HALF_OPEN)
+     */
+    void beginProbe();
+
+    /**
+     * Failed probe: re-open the circuit with a longer backoff
+     */
+    void probeFailed();
+
+    State getState() const { return state; }
+    const char *getStateName() const;
+    uint32_t getEpoch() const { return epoch; }
+    int getConsecutiveFailures() const { return consecutiveFailures; }
+    unsigned long getRetryInMs() const;
+    unsigned long getLastLatencyMs() const { return lastLatencyMs; }
+
+private:
+    State state;
+    int consecutiveFailures;
+    unsigned long backoffMs;
+    unsigned long nextProbeAt;
+    unsigned long lastLatencyMs;
+    uint32_t epoch;
+
+    static uint32_t nextEpoch;
+
+    void open();
+};
+
+#endif // LIGHT_HEALTH_H
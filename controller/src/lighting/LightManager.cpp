@@ -9,25 +9,61 @@ const char *LightManager::PREF_HOST_ADDRESS = "host_addr";
 const char *LightManager::PREF_PORT = "port";
 const char *LightManager::PREF_AUTH_TOKEN = "auth_token";
 const char *LightManager::PREF_CUSTOM_CONFIG = "custom_config";
+const char *LightManager::PREF_EXTRA_TARGETS = "extra_targets";
+const char *LightManager::PREF_LAST_PALETTE = "last_palette";
 
-LightManager::LightManager() : currentController(nullptr), isInitialized(false)
+// NVS layout of the last displayed palette (about 50 bytes)
+struct StoredPalette
 {
+    uint8_t version;
+    uint8_t colorCount;
+    int8_t brightness; // -1: controller default
+    uint8_t reserved;
+    uint32_t duration;
+    char animation[PALETTE_ANIMATION_LENGTH + 1];
+    uint8_t rgb[MAX_COLORS][3];
+};
+
+#define STORED_PALETTE_VERSION 1
+
+LightManager::LightManager() : currentController(nullptr), httpTransport(nullptr), isInitialized(false), extraTargetCount(0), hasLastPalette(false),
+      paletteRestored(false), paletteStorePending(false), paletteStoreAt(0), brightness(-1), startedLocally(false)
+{
+    for (int i = 0; i < MAX_LIGHT_TARGETS - 1; i++)
+    {
+        extraTargets[i].controller = nullptr;
+    }
 }
 
 LightManager::~LightManager()
 {
     cleanupController();
+    cleanupExtraTargets();
 }
 
 bool LightManager::begin()
 {
     Serial.println("🌈 Initializing Light Manager...");
 
+    // Additional targets are independent of the primary system
+    loadExtraTargets();
+
     // Load configuration from EEPROM
     if (loadConfiguration())
     {
         Serial.println("📋 Loaded lighting configuration: " + config.systemType);
 
+        // A strip started by beginLocal() keeps running and keeps showing
+        // the restored palette
+        if (startedLocally && currentController && currentController->getSystemType() == config.systemType)
+        {
+            startedLocally = false;
+            isInitialized = true;
+            Serial.println("✅ Keeping " + config.systemType + " controller started at boot");
+            return true;
+        }
+        startedLocally = false;
+
         // Create and initialize controller (but don't authenticate yet)
         if (createController(config.systemType))
         {
@@ -70,6 +106,9 @@ bool LightManager::begin()
                 Serial.println("⚠ Lighting controller failed to initialize (hardware may not be connected)");
                 // Don't fail completely - allow system to continue running
                 isInitialized = true; // Mark as initialized but with failed controller
+
+                // The background probe restores the controller once it answers
+                primaryHealth.trip();
                 return true;
             }
         }
@@ -101,6 +140,60 @@ bool LightManager::beginWithoutConfig()
     return true;
 }
 
+bool LightManager::beginLocal()
+{
+    if (!restoreLastPalette())
+    {
+        return false;
+    }
+
+    // Network lights get the palette once begin() has connected them
+    if (!loadConfiguration() || !isLocalSystem(config.systemType) || !createController(config.systemType))
+    {
+        return false;
+    }
+
+    if (!currentController->initialize(config))
+    {
+        cleanupController();
+        return false;
+    }
+
+    isInitialized = true;
+    startedLocally = true;
+    if (brightness >= 0)
+    {
+        currentController->setBrightness(brightness);
+    }
+
+    Serial.println("⚡ Restoring last palette on " + config.systemType + " (" + String(lastPalette.colorCount) + " colors)");
+    currentController->displayPaletteAsync(lastPalette, [](bool success)
+                                           {
+        if (!success)
+        {
+            Serial.println("⚠ Restored palette could not be shown");
+        } });
+    return true;
+}
+
+bool LightManager::replayRestoredPalette()
+{
+    if (!paletteRestored || !isInitialized)
+    {
+        return false;
+    }
+
+    Serial.println("🔁 Replaying restored palette on all lighting targets");
+    if (brightness >= 0)
+    {
+        setBrightness(brightness);
+    }
+    ColorPalette palette = lastPalette;
+    displayPaletteAsync(palette, [](const DisplayReport &report)
+                        { Serial.printf("🔁 Restored palette shown on %d/%d target(s)\n", report.successCount, report.targetCount); });
+    return true;
+}
+
 bool LightManager::configure(const String &systemType, const String &hostAddress,
                              int port, const String &authToken,
                              const JsonObject &customConfig)
@@ -154,48 +247,379 @@ bool LightManager::configure(const String &systemType, const String &hostAddress
     }
 }
 
-bool LightManager::displayPalette(const ColorPalette &palette)
+bool LightManager::configureTarget(int index, const String &systemType, const String &hostAddress,
+                                   int port, const String &authToken,
+                                   const JsonObject &customConfig)
 {
-    if (!isInitialized)
+    if (index == 0)
     {
-        Serial.println("❌ Light Manager not initialized");
+        return configure(systemType, hostAddress, port, authToken, customConfig);
+    }
+
+    if (systemType == "none")
+    {
+        return removeTarget(index);
+    }
+
+    if (index < 1 || index > extraTargetCount + 1 || index >= MAX_LIGHT_TARGETS)
+    {
+        Serial.println("❌ Invalid lighting target index: " + String(index));
         return false;
     }
 
-    if (!currentController)
+    Serial.println("🔧 Configuring lighting target " + String(index) + ": " + systemType);
+
+    LightController *controller = LightControllerFactory::createController(systemType);
+    if (!controller)
     {
-        Serial.println("❌ No lighting controller available");
+        Serial.println("❌ Unknown lighting system type: " + systemType);
         return false;
     }
 
-    if (!currentController->isReady())
+    LightConfig targetConfig;
+    targetConfig.systemType = systemType;
+    targetConfig.hostAddress = hostAddress;
+    targetConfig.port = port;
+    targetConfig.authToken = authToken;
+    targetConfig.customConfig = customConfig;
+
+    controller->setHttpTransport(httpTransport);
+    controller->setNotificationCallback([this](const String &action, const String &instructions, int timeout)
+                                        { handleUserNotification(action, instructions, timeout); });
+
+    if (!controller->initialize(targetConfig))
     {
-        Serial.println("⚠ Lighting controller not ready (hardware may not be connected)");
+        Serial.println("❌ Failed to initialize lighting target " + String(index));
+        delete controller;
         return false;
     }
 
-    Serial.println("🎨 Displaying palette: " + palette.name);
-    return currentController->displayPalette(palette);
+    if (controller->requiresAuthentication() && !controller->isReady() && controller->authenticate())
+    {
+        LightConfig updatedConfig = controller->getUpdatedConfig();
+        if (updatedConfig.hostAddress.length() > 0)
+        {
+            targetConfig.hostAddress = updatedConfig.hostAddress;
+        }
+        if (updatedConfig.port > 0)
+        {
+            targetConfig.port = updatedConfig.port;
+        }
+        if (updatedConfig.authToken.length() > 0)
+        {
+            targetConfig.authToken = updatedConfig.authToken;
+        }
+    }
+
+    LightTarget &target = extraTargets[index - 1];
+    if (index <= extraTargetCount)
+    {
+        delete target.controller;
+    }
+    else
+    {
+        extraTargetCount++;
+    }
+
+    target.controller = controller;
+    target.config = targetConfig;
+    target.health.reset();
+    saveExtraTargets();
+
+    Serial.println("✅ Lighting target " + String(index) + " configured (" + String(getTargetCount()) + " targets total)");
+    return true;
 }
 
-bool LightManager::turnOff()
+bool LightManager::removeTarget(int index)
 {
-    if (!isReady())
+    if (index < 1 || index > extraTargetCount)
     {
+        Serial.println("❌ Invalid lighting target index: " + String(index));
         return false;
     }
 
-    return currentController->turnOff();
+    delete extraTargets[index - 1].controller;
+
+    // Keep the target list contiguous
+    for (int i = index - 1; i < extraTargetCount - 1; i++)
+    {
+        extraTargets[i] = extraTargets[i + 1];
+    }
+    extraTargetCount--;
+    extraTargets[extraTargetCount].controller = nullptr;
+    extraTargets[extraTargetCount].config = LightConfig();
+
+    saveExtraTargets();
+
+    Serial.println("🗑 Removed lighting target " + String(index));
+    return true;
+}
+
+int LightManager::getTargetCount() const
+{
+    return (currentController ? 1 : 0) + extraTargetCount;
+}
+
+bool LightManager::hasReadyTarget() const
+{
+    for (int i = 0; i <= extraTargetCount; i++)
+    {
+        LightController *controller = targetController(i);
+        if (controller && controller->isReady())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LightManager::displayPalette(const ColorPalette &palette)
+{
+    struct SyncResult
+    {
+        bool done = false;
+        bool success = false;
+    };
+    std::shared_ptr<SyncResult> result = std::make_shared<SyncResult>();
+
+    displayPaletteAsync(palette, [result](const DisplayReport &report)
+                        {
+        result->done = true;
+        result->success = report.success(); });
+
+    // Every light request is bounded by its own timeout; this only guards
+    // against requests stuck behind other traffic in the transport queue
+    unsigned long startTime = millis();
+    while (!result->done && httpTransport && millis() - startTime < HTTP_TRANSPORT_DEFAULT_TIMEOUT + LIGHT_HTTP_TIMEOUT)
+    {
+        httpTransport->loop();
+        delay(1);
+    }
+
+    return result->success;
+}
+
+void LightManager::displayPaletteAsync(const ColorPalette &palette, DisplayReportCallback callback)
+{
+    if (!isInitialized)
+    {
+        Serial.println("❌ Light Manager not initialized");
+        if (callback)
+        {
+            callback(DisplayReport());
+        }
+        return;
+    }
+
+    lastPalette = palette;
+    hasLastPalette = true;
+    paletteRestored = false;
+
+    // Collect targets before dispatching, so a controller that completes
+    // inline (WS2812) cannot finish the fan-out before the others are started
+    LightController *controllers[MAX_LIGHT_TARGETS];
+    std::shared_ptr<DisplayFanOut> fanOut = std::make_shared<DisplayFanOut>();
+    fanOut->startedAt = millis();
+    fanOut->report.startedAt = fanOut->startedAt;
+    fanOut->callback = callback;
+    fanOut->palette = palette;
+    fanOut->pending = 0;
+
+    for (int i = 0; i <= extraTargetCount; i++)
+    {
+        LightController *controller = targetController(i);
+        if (!controller)
+        {
+            continue;
+        }
+
+        if (!controller->isReady())
+        {
+            Serial.println("⚠ Lighting target " + String(i) + " not ready (hardware may not be connected)");
+            continue;
+        }
+
+        int slot = fanOut->report.targetCount++;
+        LightConfig targetCfg = targetConfig(i);
+        LightHealth *health = targetHealth(i);
+        TargetResult &result = fanOut->report.results[slot];
+        result.targetIndex = i;
+        result.systemType = targetCfg.systemType;
+        result.hostAddress = targetCfg.hostAddress;
+        fanOut->epochs[slot] = health->getEpoch();
+
+        // Fail fast while the target is known to be down
+        if (!health->allowRequest())
+        {
+            result.circuitOpen = true;
+            controllers[slot] = nullptr;
+            continue;
+        }
+
+        controllers[slot] = controller;
+        fanOut->pending++;
+    }
+
+    if (fanOut->report.targetCount == 0)
+    {
+        Serial.println("❌ No lighting controller available");
+        if (callback)
+        {
+            callback(fanOut->report);
+        }
+        return;
+    }
+
+    Serial.println("🎨 Displaying palette: " + String(palette.name) + " on " + String(fanOut->pending) + "/" +
+                   String(fanOut->report.targetCount) + " target(s)");
+
+    if (fanOut->pending == 0)
+    {
+        completeDisplay(fanOut);
+        return;
+    }
+
+    for (int slot = 0; slot < fanOut->report.targetCount; slot++)
+    {
+        if (!controllers[slot])
+        {
+            continue;
+        }
+
+        controllers[slot]->displayPaletteAsync(palette, [this, fanOut, slot](bool success)
+                                               {
+            TargetResult &result = fanOut->report.results[slot];
+            result.success = success;
+            result.latencyMs = millis() - fanOut->startedAt;
+            if (success)
+            {
+                fanOut->report.successCount++;
+            }
+
+            // The target may have been reconfigured meanwhile; match it by epoch
+            int index = findTargetByEpoch(fanOut->epochs[slot]);
+            if (index >= 0)
+            {
+                LightHealth *health = targetHealth(index);
+                if (success)
+                {
+                    health->recordSuccess(result.latencyMs);
+                }
+                else
+                {
+                    health->recordFailure();
+                }
+            }
+
+            if (--fanOut->pending == 0)
+            {
+                completeDisplay(fanOut);
+            } });
+    }
+}
+
+void LightManager::completeDisplay(const std::shared_ptr<DisplayFanOut> &fanOut)
+{
+    fanOut->report.latencyMs = millis() - fanOut->startedAt;
+    lastReport = fanOut->report;
+
+    Serial.println("📊 Palette displayed on " + String(lastReport.successCount) + "/" + String(lastReport.targetCount) +
+                   " target(s) in " + String(lastReport.latencyMs) + " ms");
+    for (int i = 0; i < lastReport.targetCount; i++)
+    {
+        const TargetResult &r = lastReport.results[i];
+        if (r.circuitOpen)
+        {
+            Serial.println("   [" + String(r.targetIndex) + "] " + r.systemType + ": ⏸ skipped (circuit open)");
+        }
+        else
+        {
+            Serial.println("   [" + String(r.targetIndex) + "] " + r.systemType + ": " +
+                           String(r.success ? "✅" : "❌") + " " + String(r.latencyMs) + " ms");
+        }
+    }
+
+    if (lastReport.successCount > 0)
+    {
+        displayedPalette = fanOut->palette;
+        schedulePaletteStore();
+    }
+
+    if (fanOut->callback)
+    {
+        fanOut->callback(lastReport);
+    }
+}
+
+void LightManager::getTargetStatus(JsonArray targets)
+{
+    for (int i = 0; i <= extraTargetCount; i++)
+    {
+        LightController *controller = targetController(i);
+        if (!controller)
+        {
+            continue;
+        }
+
+        LightConfig targetCfg = targetConfig(i);
+        JsonObject target = targets.add<JsonObject>();
+        target["index"] = i;
+        target["systemType"] = targetCfg.systemType;
+        target["hostAddress"] = targetCfg.hostAddress;
+        target["isReady"] = controller->isReady();
+
+        LightHealth *health = targetHealth(i);
+        target["circuit"] = health->getStateName();
+        target["failures"] = health->getConsecutiveFailures();
+        if (health->getState() == LightHealth::OPEN)
+        {
+            target["retryInMs"] = health->getRetryInMs();
+        }
+
+        for (int r = 0; r < lastReport.targetCount; r++)
+        {
+            if (lastReport.results[r].targetIndex == i)
+            {
+                target["lastSuccess"] = lastReport.results[r].success;
+                target["lastLatencyMs"] = lastReport.results[r].latencyMs;
+                break;
+            }
+        }
+    }
+}
+
+bool LightManager::turnOff()
+{
+    bool success = getTargetCount() > 0;
+    for (int i = 0; i <= extraTargetCount; i++)
+    {
+        LightController *controller = targetController(i);
+        if (controller && controller->isReady())
+        {
+            success = controller->turnOff() && success;
+        }
+    }
+    return success;
 }
 
 bool LightManager::setBrightness(int brightness)
 {
-    if (!isReady())
+    this->brightness = constrain(brightness, 0, 100);
+    if (displayedPalette.colorCount > 0)
     {
-        return false;
+        schedulePaletteStore();
     }
 
-    return currentController->setBrightness(brightness);
+    bool success = getTargetCount() > 0;
+    for (int i = 0; i <= extraTargetCount; i++)
+    {
+        LightController *controller = targetController(i);
+        if (controller && controller->isReady())
+        {
+            success = controller->setBrightness(brightness) && success;
+        }
+    }
+    return success;
 }
 
 bool LightManager::testConnection()
@@ -218,17 +642,15 @@ String LightManager::getStatus()
     return currentController->getStatus();
 }
 
-JsonObject LightManager::getCapabilities()
+void LightManager::getCapabilities(JsonObject caps)
 {
     if (!isReady())
     {
-        JsonDocument doc;
-        JsonObject caps = doc.to<JsonObject>();
         caps["error"] = "Not initialized";
-        return caps;
+        return;
     }
 
-    return currentController->getCapabilities();
+    currentController->getCapabilities(caps);
 }
 
 bool LightManager::requiresAuthentication()
@@ -575,8 +997,11 @@ void LightManager::resetConfiguration()
     preferences.begin(PREF_NAMESPACE, false);
     preferences.clear();
     preferences.end();
+    paletteStorePending = false;
+    displayedPalette = ColorPalette();
 
     cleanupController();
+    cleanupExtraTargets();
     isInitialized = false;
 
     // Reset to empty config
@@ -611,11 +1036,7 @@ LightConfig LightManager::createDefaultConfig(const String &systemType)
         config.port = 0; // Not applicable for direct control
 
         // Default WS2812 configuration
-        JsonDocument doc;
-        doc["ledPin"] = 2;
-        doc["ledCount"] = 30;
-        doc["brightness"] = 255;
-        config.customConfig = doc.as<JsonObject>();
+        config.customConfig = createDefaultCustomConfig(systemType);
     }
 
     return config;
@@ -623,6 +1044,16 @@ LightConfig LightManager::createDefaultConfig(const String &systemType)
 
 void LightManager::loop()
 {
+    // Probe targets whose circuit is open so they recover without a palette
+    probeTargets();
+
+    if (paletteStorePending && (long)(millis() - paletteStoreAt) >= 0 &&
+        (!httpTransport || httpTransport->pendingCount() == 0))
+    {
+        paletteStorePending = false;
+        storeLastPalette();
+    }
+
     if (!isReady())
     {
         return;
@@ -637,9 +1068,98 @@ void LightManager::loop()
     }
 }
 
+void LightManager::probeTargets()
+{
+    for (int i = 0; i <= extraTargetCount; i++)
+    {
+        LightController *controller = targetController(i);
+        LightHealth *health = targetHealth(i);
+        if (!controller || !health->probeDue())
+        {
+            continue;
+        }
+
+        health->beginProbe();
+        uint32_t epoch = health->getEpoch();
+        controller->probeAsync([this, epoch](bool reachable)
+                               {
+            int index = findTargetByEpoch(epoch);
+            if (index < 0)
+            {
+                return;
+            }
+
+            if (!reachable)
+            {
+                targetHealth(index)->probeFailed();
+                return;
+            }
+
+            recoverTarget(index); });
+    }
+}
+
+void LightManager::recoverTarget(int index)
+{
+    LightController *controller = targetController(index);
+    LightHealth *health = targetHealth(index);
+
+    // The probe answer proves reachability, so the circuit closes right away
+    health->recordSuccess(0);
+    Serial.println("💡 Lighting target " + String(index) + " (" + targetConfig(index).systemType + ") is reachable again");
+
+    if (controller->isReady())
+    {
+        replayLastPalette(index);
+        return;
+    }
+
+    // A controller whose initialize() failed is set up again without blocking the lighting task
+    uint32_t epoch = health->getEpoch();
+    controller->restoreAsync(targetConfig(index), [this, epoch](bool restored)
+                             {
+        int current = findTargetByEpoch(epoch);
+        if (current < 0)
+        {
+            return;
+        }
+
+        if (!restored)
+        {
+            targetHealth(current)->recordFailure();
+            return;
+        }
+
+        replayLastPalette(current); });
+}
+
+void LightManager::replayLastPalette(int index)
+{
+    if (!hasLastPalette)
+    {
+        return;
+    }
+
+    // Bring the light up to date with the palette it missed
+    Serial.println("🔁 Replaying last palette on target " + String(index));
+    uint32_t epoch = targetHealth(index)->getEpoch();
+    targetController(index)->displayPaletteAsync(lastPalette, [this, epoch](bool success)
+                                                 {
+        int current = findTargetByEpoch(epoch);
+        if (current >= 0 && !success)
+        {
+            targetHealth(current)->recordFailure();
+        } });
+}
+
 bool LightManager::createController(const String &systemType)
 {
     currentController = LightControllerFactory::createController(systemType);
+    primaryHealth.reset();
+    if (currentController)
+    {
+        currentController->setHttpTransport(httpTransport);
+    }
     return (currentController != nullptr);
 }
 
@@ -653,24 +1173,235 @@ void LightManager::cleanupController()
     isInitialized = false;
 }
 
-JsonObject LightManager::parseCustomConfig(const String &configStr)
+LightController *LightManager::targetController(int index) const
+{
+    if (index == 0)
+    {
+        return currentController;
+    }
+    return (index <= extraTargetCount) ? extraTargets[index - 1].controller : nullptr;
+}
+
+LightConfig LightManager::targetConfig(int index) const
+{
+    if (index == 0)
+    {
+        return config;
+    }
+    return (index <= extraTargetCount) ? extraTargets[index - 1].config : LightConfig();
+}
+
+LightHealth *LightManager::targetHealth(int index)
+{
+    if (index == 0)
+    {
+        return &primaryHealth;
+    }
+    return &extraTargets[index - 1].health;
+}
+
+int LightManager::findTargetByEpoch(uint32_t epoch)
+{
+    for (int i = 0; i <= extraTargetCount; i++)
+    {
+        if (targetController(i) && targetHealth(i)->getEpoch() == epoch)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void LightManager::cleanupExtraTargets()
+{
+    for (int i = 0; i < extraTargetCount; i++)
+    {
+        delete extraTargets[i].controller;
+        extraTargets[i].controller = nullptr;
+        extraTargets[i].config = LightConfig();
+    }
+    extraTargetCount = 0;
+}
+
+bool LightManager::saveExtraTargets()
+{
+    JsonDocument doc;
+    JsonArray targets = doc.to<JsonArray>();
+
+    for (int i = 0; i < extraTargetCount; i++)
+    {
+        const LightConfig &targetCfg = extraTargets[i].config;
+        JsonObject target = targets.add<JsonObject>();
+        target["type"] = targetCfg.systemType;
+        target["host"] = targetCfg.hostAddress;
+        target["port"] = targetCfg.port;
+        target["token"] = targetCfg.authToken;
+        target["custom"] = serializeCustomConfig(targetCfg.customConfig);
+    }
+
+    String targetsStr;
+    serializeJson(doc, targetsStr);
+
+    preferences.begin(PREF_NAMESPACE, false);
+    bool success = preferences.putString(PREF_EXTRA_TARGETS, targetsStr) > 0;
+    preferences.end();
+
+    if (!success)
+    {
+        Serial.println("❌ Failed to save additional lighting targets");
+    }
+    return success;
+}
+
+void LightManager::loadExtraTargets()
+{
+    cleanupExtraTargets();
+
+    preferences.begin(PREF_NAMESPACE, true);
+    String targetsStr = preferences.getString(PREF_EXTRA_TARGETS, "");
+    preferences.end();
+
+    if (targetsStr.length() == 0)
+    {
+        return;
+    }
+
+    JsonDocument doc;
+    if (deserializeJson(doc, targetsStr))
+    {
+        Serial.println("⚠ Stored lighting targets are corrupt - ignoring");
+        return;
+    }
+
+    for (JsonObject target : doc.as<JsonArray>())
+    {
+        if (extraTargetCount >= MAX_LIGHT_TARGETS - 1)
+        {
+            break;
+        }
+
+        LightController *controller = LightControllerFactory::createController(target["type"].as<String>());
+        if (!controller)
+        {
+            continue;
+        }
+
+        LightTarget &slot = extraTargets[extraTargetCount++];
+        slot.controller = controller;
+        slot.config.systemType = target["type"].as<String>();
+        slot.config.hostAddress = target["host"].as<String>();
+        slot.config.port = target["port"] | 80;
+        slot.config.authToken = target["token"].as<String>();
+        slot.config.customConfig = parseCustomConfig(target["custom"].as<String>());
+
+        controller->setHttpTransport(httpTransport);
+        controller->setNotificationCallback([this](const String &action, const String &instructions, int timeout)
+                                            { handleUserNotification(action, instructions, timeout); });
+
+        slot.health.reset();
+        if (!controller->initialize(slot.config))
+        {
+            Serial.println("⚠ Lighting target " + String(extraTargetCount) + " (" + slot.config.systemType + ") failed to initialize");
+            slot.health.trip();
+        }
+    }
+
+    Serial.println("📋 Loaded " + String(extraTargetCount) + " additional lighting target(s)");
+}
+
+bool LightManager::restoreLastPalette()
+{
+    StoredPalette stored;
+    preferences.begin(PREF_NAMESPACE, true);
+    bool found = preferences.getBytesLength(PREF_LAST_PALETTE) == sizeof(stored) &&
+                 preferences.getBytes(PREF_LAST_PALETTE, &stored, sizeof(stored)) == sizeof(stored);
+    preferences.end();
+
+    if (!found || stored.version != STORED_PALETTE_VERSION || stored.colorCount == 0 || stored.colorCount > MAX_COLORS)
+    {
+        return false;
+    }
+
+    ColorPalette palette;
+    palette.setName("Restored");
+    palette.colorCount = stored.colorCount;
+    palette.duration = stored.duration;
+    stored.animation[PALETTE_ANIMATION_LENGTH] = '\0';
+    palette.setAnimation(stored.animation);
+    for (int i = 0; i < palette.colorCount; i++)
+    {
+        palette.colors[i] = RGBColor(stored.rgb[i][0], stored.rgb[i][1], stored.rgb[i][2]);
+    }
+
+    lastPalette = palette;
+    displayedPalette = palette;
+    hasLastPalette = true;
+    paletteRestored = true;
+    brightness = stored.brightness;
+    return true;
+}
+
+void LightManager::schedulePaletteStore()
+{
+    // A burst of palettes costs one write, of the latest one
+    if (!paletteStorePending)
+    {
+        paletteStorePending = true;
+        paletteStoreAt = millis() + LIGHT_PALETTE_STORE_DELAY;
+    }
+}
+
+void LightManager::storeLastPalette()
+{
+    StoredPalette stored;
+    memset(&stored, 0, sizeof(stored));
+    stored.version = STORED_PALETTE_VERSION;
+    stored.colorCount = min(displayedPalette.colorCount, MAX_COLORS);
+    stored.brightness = brightness;
+    stored.duration = displayedPalette.duration;
+    strlcpy(stored.animation, displayedPalette.animation, sizeof(stored.animation));
+    for (int i = 0; i < stored.colorCount; i++)
+    {
+        stored.rgb[i][0] = displayedPalette.colors[i].r;
+        stored.rgb[i][1] = displayedPalette.colors[i].g;
+        stored.rgb[i][2] = displayedPalette.colors[i].b;
+    }
+
+    // Only touch flash when the palette actually changed
+    StoredPalette current;
+    preferences.begin(PREF_NAMESPACE, false);
+    if (preferences.getBytes(PREF_LAST_PALETTE, &current, sizeof(current)) != sizeof(current) ||
+        memcmp(&current, &stored, sizeof(stored)) != 0)
+    {
+        preferences.putBytes(PREF_LAST_PALETTE, &stored, sizeof(stored));
+    }
+    preferences.end();
+}
+
+bool LightManager::isLocalSystem(const String &systemType)
+{
+    return systemType == "ws2812";
+}
+
+JsonDocument LightManager::parseCustomConfig(const String &configStr)
 {
     JsonDocument doc;
 
     if (configStr.length() > 0)
     {
         DeserializationError error = deserializeJson(doc, configStr);
-        if (!error)
+        if (!error && doc.is<JsonObject>())
         {
-            return doc.as<JsonObject>();
+            return doc;
         }
     }
 
     // Return empty object if parsing fails
-    return doc.to<JsonObject>();
+    doc.to<JsonObject>();
+    return doc;
 }
 
-String LightManager::serializeCustomConfig(const JsonObject &config)
+String LightManager::serializeCustomConfig(const JsonDocument &config)
 {
     if (config.isNull())
     {
@@ -682,7 +1413,7 @@ String LightManager::serializeCustomConfig(const JsonObject &config)
     return result;
 }
 
-JsonObject LightManager::createDefaultCustomConfig(const String &systemType)
+JsonDocument LightManager::createDefaultCustomConfig(const String &systemType)
 {
     JsonDocument doc;
 
@@ -701,7 +1432,7 @@ JsonObject LightManager::createDefaultCustomConfig(const String &systemType)
         // Nanoleaf config will be auto-discovered
     }
 
-    return doc.as<JsonObject>();
+    return doc;
 }
 
 void LightManager::handleUserNotification(const String &action, const String &instructions, int timeout)
@@ -2,8 +2,45 @@
 #define LIGHT_MANAGER_H
 
 #include "LightController.h"
+#include "LightHealth.h"
 #include <ArduinoJson.h>
 #include <Preferences.h>
+#include <memory>
+#include "../config.h"
+
+/**
+ * Outcome of a palette display on one lighting target
+ */
+struct TargetResult
+{
+    String systemType;
+    String hostAddress;
+    int targetIndex;
+    bool success;
+    bool circuitOpen; // Skipped because the target is known to be down
+    unsigned long latencyMs;
+
+    TargetResult() : targetIndex(0), success(false), circuitOpen(false), latencyMs(0) {}
+};
+
+/**
+ * Outcome of a palette display across all lighting targets.
+ * latencyMs is the time from startedAt (dispatch) until the slowest target completed.
+ */
+struct DisplayReport
+{
+    TargetResult results[MAX_LIGHT_TARGETS];
+    int targetCount;
+    int successCount;
+    unsigned long startedAt;
+    unsigned long latencyMs;
+
+    DisplayReport() : targetCount(0), successCount(0), startedAt(0), latencyMs(0) {}
+
+    bool success() const { return targetCount > 0 && successCount == targetCount; }
+};
+
+typedef std::function<void(const DisplayReport &)> DisplayReportCallback;
 
 /**
  * Light Manager
@@ -15,10 +52,49 @@ class LightManager
 {
 private:
     LightController *currentController;
+    HttpTransport *httpTransport;
     LightConfig config;
     Preferences preferences;
     bool isInitialized;
 
+    // Additional lighting systems driven alongside the primary one.
+    // Target index 0 is always the primary controller/config above.
+    struct LightTarget
+    {
+        LightController *controller;
+        LightConfig config;
+        LightHealth health;
+    };
+    LightTarget extraTargets[MAX_LIGHT_TARGETS - 1];
+    int extraTargetCount;
+    LightHealth primaryHealth;
+    DisplayReport lastReport;
+
+    // Replayed on a target once its circuit closes again
+    ColorPalette lastPalette;
+    bool hasLastPalette;
+    bool paletteRestored; // lastPalette came from NVS and nothing newer was displayed
+
+    // Last palette a target actually showed, restored after a power cut. It
+    // is written to NVS from loop()
+    // once LIGHT_PALETTE_STORE_DELAY has passed and no light request is in
+    // flight, so the flash write never delays a dispatch.
+    ColorPalette displayedPalette;
+    bool paletteStorePending;
+    unsigned long paletteStoreAt;
+    int brightness;       // Last setBrightness() value, -1 for controller defaults
+    bool startedLocally;  // Primary controller was brought up by beginLocal()
+
+    struct DisplayFanOut
+    {
+        DisplayReport report;
+        uint32_t epochs[MAX_LIGHT_TARGETS]; // Health epoch of each dispatched target
+        int pending;
+        unsigned long startedAt;
+        DisplayReportCallback callback;
+        ColorPalette palette; // Persisted once a target has shown it
+    };
+
     // Configuration keys for EEPROM storage
     static const char *PREF_NAMESPACE;
     static const char *PREF_SYSTEM_TYPE;
@@ -26,6 +102,8 @@ private:
     static const char *PREF_PORT;
     static const char *PREF_AUTH_TOKEN;
     static const char *PREF_CUSTOM_CONFIG;
+    static const char *PREF_EXTRA_TARGETS;
+    static const char *PREF_LAST_PALETTE;
 
 public:
     LightManager();
@@ -43,6 +121,21 @@ public:
      */
     bool beginWithoutConfig();
 
+    /**
+     * Show the palette persisted before the last power cut on directly
+     * attached lights (WS2812) right at boot, before any networking.
+     * Network lights get it from replayRestoredPalette() after begin().
+     * @return true when the restored palette is being shown
+     */
+    bool beginLocal();
+
+    /**
+     * Display the restored palette on all targets unless a newer palette
+     * has been displayed since boot
+     * @return true when a replay was started
+     */
+    bool replayRestoredPalette();
+
     /**
      * Configure the lighting system
      * @param systemType Type of lighting system (nanoleaf, wled, ws2812)
@@ -56,10 +149,50 @@ public:
                    const JsonObject &customConfig = JsonObject());
 
     /**
-     * Display a color palette on the configured lighting system
+     * Configure an additional lighting target (index 1..MAX_LIGHT_TARGETS-1).
+     * Passing systemType "none" removes the target at that index.
+     */
+    bool configureTarget(int index, const String &systemType, const String &hostAddress,
+                         int port = 80, const String &authToken = "",
+                         const JsonObject &customConfig = JsonObject());
+
+    /**
+     * Remove an additional lighting target
+     */
+    bool removeTarget(int index);
+
+    /**
+     * Number of configured targets, including the primary one
+     */
+    int getTargetCount() const;
+
+    /**
+     * Display a color palette on all configured lighting systems and wait
+     * until every target has answered
      */
     bool displayPalette(const ColorPalette &palette);
 
+    /**
+     * Display a color palette on all targets concurrently without blocking.
+     * The callback runs once the slowest target has completed.
+     */
+    void displayPaletteAsync(const ColorPalette &palette, DisplayReportCallback callback);
+
+    /**
+     * Result of the most recent palette display
+     */
+    const DisplayReport &getLastDisplayReport() const { return lastReport; }
+
+    /**
+     * Add per-target configuration and readiness to a status document
+     */
+    void getTargetStatus(JsonArray targets);
+
+    /**
+     * Check if at least one target can display palettes
+     */
+    bool hasReadyTarget() const;
+
     /**
      * Turn off all lights
      */
@@ -83,7 +216,7 @@ public:
     /**
      * Get system capabilities
      */
-    JsonObject getCapabilities();
+    void getCapabilities(JsonObject caps);
 
     /**
      * Check if system requires authentication
@@ -134,6 +267,11 @@ public:
         userNotificationCallback = callback;
     }
 
+    /**
+     * Set the HTTP transport handed to network controllers
+     */
+    void setHttpTransport(HttpTransport *transport) { httpTransport = transport; }
+
     /**
      * Save current configuration to EEPROM
      */
@@ -178,9 +316,24 @@ public:
 private:
     bool createController(const String &systemType);
     void cleanupController();
-    JsonObject parseCustomConfig(const String &configStr);
-    String serializeCustomConfig(const JsonObject &config);
-    JsonObject createDefaultCustomConfig(const String &systemType);
+    LightController *targetController(int index) const;
+    LightConfig targetConfig(int index) const;
+    LightHealth *targetHealth(int index);
+    int findTargetByEpoch(uint32_t epoch);
+    void completeDisplay(const std::shared_ptr<DisplayFanOut> &fanOut);
+    void probeTargets();
+    void recoverTarget(int index);
+    void replayLastPalette(int index);
+    void cleanupExtraTargets();
+    bool saveExtraTargets();
+    void loadExtraTargets();
+    bool restoreLastPalette();
+    void schedulePaletteStore();
+    void storeLastPalette();
+    static bool isLocalSystem(const String &systemType);
+    JsonDocument parseCustomConfig(const String &configStr);
+    String serializeCustomConfig(const JsonDocument &config);
+    static JsonDocument createDefaultCustomConfig(const String &systemType);
 
     // User notification handling
     void handleUserNotification(const String &action, const String &instructions, int timeout);
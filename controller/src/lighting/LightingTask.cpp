@@ -0,0 +1,542 @@
+#include "LightingTask.h"
+
+LightingTask::LightingTask(LightManager *lightManager, HttpTransport *transport)
+    : lightManager(lightManager), transport(transport), taskHandle(nullptr), nextId(1), currentCommandId(0),
+      commandHead(0), commandCount(0), eventHead(0), eventCount(0),
+      snapshotReady(false), snapshotNeedsAuth(false), snapshotTargetCount(0), pendingBegins(0), statusCached(false)
+{
+    mutex = xSemaphoreCreateMutex();
+}
+
+bool LightingTask::begin()
+{
+    if (taskHandle)
+    {
+        return true;
+    }
+
+    // User notifications are raised on this task; hand them to the consumer as events
+    lightManager->setUserNotificationCallback([this](const String &action, const String &instructions, int timeout)
+                                              {
+        LightEvent event;
+        event.type = LIGHT_EVENT_USER_ACTION;
+        event.commandId = currentCommandId;
+        event.success = true;
+        event.action = action;
+        event.instructions = instructions;
+        event.timeout = timeout;
+        pushEvent(event); });
+
+    updateSnapshot();
+
+    BaseType_t result = xTaskCreate(taskEntry, "lighting", LIGHTING_TASK_STACK_SIZE, this,
+                                    LIGHTING_TASK_PRIORITY, &taskHandle);
+    if (result != pdPASS)
+    {
+        Serial.println("❌ Failed to start lighting task");
+        taskHandle = nullptr;
+        return false;
+    }
+
+    Serial.println("✅ Lighting task started");
+    return true;
+}
+
+uint32_t LightingTask::post(const LightCommand &command)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    uint32_t id = nextId++;
+    if (nextId == 0)
+    {
+        nextId = 1;
+    }
+
+    if (commandCount >= LIGHTING_COMMAND_QUEUE_SIZE)
+    {
+        // Only the newest palette matters: replace a queued one instead of dropping
+        if (command.type == LIGHT_CMD_DISPLAY_PALETTE)
+        {
+            for (int i = commandCount - 1; i >= 0; i--)
+            {
+                LightCommand &queued = commands[(commandHead + i) % LIGHTING_COMMAND_QUEUE_SIZE];
+                if (queued.type == LIGHT_CMD_DISPLAY_PALETTE)
+                {
+                    Serial.printf("⏭ Lighting queue full - replacing pending palette %s\n", queued.palette.messageId);
+                    queued = command;
+                    queued.id = id;
+                    xSemaphoreGive(mutex);
+                    if (taskHandle)
+                    {
+                        xTaskNotifyGive(taskHandle);
+                    }
+                    return id;
+                }
+            }
+        }
+
+        xSemaphoreGive(mutex);
+        Serial.println("⚠ Lighting command queue full - command dropped");
+        return 0;
+    }
+
+    LightCommand &slot = commands[(commandHead + commandCount) % LIGHTING_COMMAND_QUEUE_SIZE];
+    slot = command;
+    slot.id = id;
+    commandCount++;
+    if (command.type == LIGHT_CMD_BEGIN)
+    {
+        pendingBegins++;
+    }
+
+    xSemaphoreGive(mutex);
+
+    if (taskHandle)
+    {
+        xTaskNotifyGive(taskHandle);
+    }
+    return id;
+}
+
+uint32_t LightingTask::displayPalette(const ColorPalette &palette)
+{
+    LightCommand command;
+    command.type = LIGHT_CMD_DISPLAY_PALETTE;
+    command.palette = palette;
+    return post(command);
+}
+
+uint32_t LightingTask::configure(int targetIndex, const String &systemType, const String &hostAddress,
+                                 int port, const String &authToken, const String &customConfig, bool authenticate)
+{
+    LightCommand command;
+    command.type = LIGHT_CMD_CONFIGURE;
+    command.targetIndex = targetIndex;
+    command.systemType = systemType;
+    command.hostAddress = hostAddress;
+    command.port = port;
+    command.authToken = authToken;
+    command.customConfig = customConfig;
+    command.authenticate = authenticate;
+    return post(command);
+}
+
+uint32_t LightingTask::authenticate()
+{
+    LightCommand command;
+    command.type = LIGHT_CMD_AUTHENTICATE;
+    return post(command);
+}
+
+uint32_t LightingTask::test(const String &deviceId)
+{
+    LightCommand command;
+    command.type = LIGHT_CMD_TEST;
+    command.reference = deviceId;
+    return post(command);
+}
+
+uint32_t LightingTask::requestStatus(bool refresh)
+{
+    LightCommand command;
+    command.type = LIGHT_CMD_REPORT_STATUS;
+    command.refresh = refresh;
+    return post(command);
+}
+
+uint32_t LightingTask::reloadConfiguration()
+{
+    LightCommand command;
+    command.type = LIGHT_CMD_BEGIN;
+    return post(command);
+}
+
+uint32_t LightingTask::resetConfiguration()
+{
+    LightCommand command;
+    command.type = LIGHT_CMD_RESET;
+    return post(command);
+}
+
+bool LightingTask::pollEvent(LightEvent &event)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    if (eventCount == 0)
+    {
+        xSemaphoreGive(mutex);
+        return false;
+    }
+
+    event = events[eventHead];
+    events[eventHead] = LightEvent();
+    eventHead = (eventHead + 1) % LIGHTING_EVENT_QUEUE_SIZE;
+    eventCount--;
+
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+String LightingTask::getSystemType()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    String systemType = snapshotSystemType;
+    xSemaphoreGive(mutex);
+    return systemType;
+}
+
+bool LightingTask::isReady()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool ready = snapshotReady;
+    xSemaphoreGive(mutex);
+    return ready;
+}
+
+bool LightingTask::acceptsPalettes()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool accepts = snapshotTargetCount > 0 || pendingBegins > 0;
+    xSemaphoreGive(mutex);
+    return accepts;
+}
+
+bool LightingTask::requiresUserAuthentication()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool needsAuth = snapshotNeedsAuth;
+    xSemaphoreGive(mutex);
+    return needsAuth;
+}
+
+int LightingTask::getTargetCount()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int count = snapshotTargetCount;
+    xSemaphoreGive(mutex);
+    return count;
+}
+
+int LightingTask::pendingCommands()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int count = commandCount;
+    xSemaphoreGive(mutex);
+    return count;
+}
+
+void LightingTask::taskEntry(void *param)
+{
+    static_cast<LightingTask *>(param)->run();
+}
+
+void LightingTask::run()
+{
+    for (;;)
+    {
+        LightCommand command;
+        while (takeCommand(command))
+        {
+            currentCommandId = command.id;
+            execute(command);
+            currentCommandId = 0;
+            updateSnapshot();
+
+            if (command.type == LIGHT_CMD_BEGIN)
+            {
+                // Counted down after the snapshot, so acceptsPalettes() always
+                // sees either the pending BEGIN or the targets it loaded
+                xSemaphoreTake(mutex, portMAX_DELAY);
+                pendingBegins--;
+                xSemaphoreGive(mutex);
+            }
+
+            // Deliver completions between commands so a burst of
+            // configuration work does not delay palette results
+            transport->loop();
+        }
+
+        // Light requests sent from this task complete here
+        transport->loop();
+        lightManager->loop();
+
+        // Sleep until a command is posted, waking periodically for HTTP completions
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(transport->pendingCount() > 0 ? 5 : 50));
+    }
+}
+
+bool LightingTask::hasQueuedPalette()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool found = false;
+    for (int i = 0; i < commandCount && !found; i++)
+    {
+        found = commands[(commandHead + i) % LIGHTING_COMMAND_QUEUE_SIZE].type == LIGHT_CMD_DISPLAY_PALETTE;
+    }
+    xSemaphoreGive(mutex);
+    return found;
+}
+
+bool LightingTask::takeCommand(LightCommand &command)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    if (commandCount == 0)
+    {
+        xSemaphoreGive(mutex);
+        return false;
+    }
+
+    command = commands[commandHead];
+    commands[commandHead] = LightCommand();
+    commandHead = (commandHead + 1) % LIGHTING_COMMAND_QUEUE_SIZE;
+    commandCount--;
+
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+void LightingTask::execute(const LightCommand &command)
+{
+    switch (command.type)
+    {
+    case LIGHT_CMD_BEGIN:
+    {
+        LightEvent event;
+        event.type = LIGHT_EVENT_READY;
+        event.commandId = command.id;
+        event.success = lightManager->begin();
+        event.status = buildStatus(true);
+        pushEvent(event);
+
+        // Network lights were dark since the power cut; show them the
+        // palette restored at boot unless a new one arrived meanwhile,
+        // including one already queued behind this command
+        if (!hasQueuedPalette())
+        {
+            lightManager->replayRestoredPalette();
+        }
+        break;
+    }
+
+    case LIGHT_CMD_DISPLAY_PALETTE:
+    {
+        // Keep the message id in a fixed buffer; it is only turned into a
+        // String once the result is reported
+        struct PaletteRef
+        {
+            uint32_t id;
+            char messageId[PALETTE_ID_LENGTH + 1];
+        } ref;
+        ref.id = command.id;
+        strlcpy(ref.messageId, command.palette.messageId, sizeof(ref.messageId));
+
+        lightManager->displayPaletteAsync(command.palette, [this, ref](const DisplayReport &report)
+                                          {
+            LightEvent event;
+            event.type = LIGHT_EVENT_PALETTE_DISPLAYED;
+            event.commandId = ref.id;
+            event.success = report.success();
+            event.reference = ref.messageId;
+            event.report = report;
+            pushEvent(event); });
+        break;
+    }
+
+    case LIGHT_CMD_CONFIGURE:
+        executeConfigure(command);
+        break;
+
+    case LIGHT_CMD_AUTHENTICATE:
+    {
+        reportProgress(command.id, 10, "authenticating");
+
+        LightEvent event;
+        event.type = LIGHT_EVENT_AUTHENTICATED;
+        event.commandId = command.id;
+        event.success = lightManager->authenticateLightingSystem();
+        event.status = buildStatus(true);
+        pushEvent(event);
+        break;
+    }
+
+    case LIGHT_CMD_TEST:
+        executeTest(command);
+        break;
+
+    case LIGHT_CMD_REPORT_STATUS:
+    {
+        LightEvent event;
+        event.type = LIGHT_EVENT_STATUS;
+        event.commandId = command.id;
+        event.success = true;
+        event.status = buildStatus(command.refresh);
+        pushEvent(event);
+        break;
+    }
+
+    case LIGHT_CMD_RESET:
+        lightManager->resetConfiguration();
+        statusCached = false;
+        break;
+    }
+}
+
+void LightingTask::executeConfigure(const LightCommand &command)
+{
+    // configureTarget() copies the custom settings into its LightConfig, so a local document is enough
+    JsonDocument customDoc;
+    JsonObject customConfig;
+    if (command.customConfig.length() > 0 && !deserializeJson(customDoc, command.customConfig))
+    {
+        customConfig = customDoc.as<JsonObject>();
+    }
+
+    reportProgress(command.id, 10, "configuring");
+
+    LightEvent event;
+    event.type = LIGHT_EVENT_CONFIGURED;
+    event.commandId = command.id;
+    event.reference = command.systemType;
+    event.success = lightManager->configureTarget(command.targetIndex, command.systemType, command.hostAddress,
+                                                  command.port, command.authToken, customConfig);
+
+    if (event.success && command.authenticate)
+    {
+        Serial.println("🔐 Starting " + command.systemType + " authentication and discovery...");
+        reportProgress(command.id, 40, "authenticating");
+        event.success = lightManager->authenticateLightingSystem();
+    }
+
+    event.status = buildStatus(true);
+    pushEvent(event);
+}
+
+void LightingTask::executeTest(const LightCommand &command)
+{
+    LightEvent event;
+    event.type = LIGHT_EVENT_TESTED;
+    event.commandId = command.id;
+    event.reference = command.reference;
+
+    reportProgress(command.id, 10, "testingConnection");
+    event.success = lightManager->testConnection();
+
+    if (event.success)
+    {
+        Serial.println("💡 Displaying test pattern...");
+        reportProgress(command.id, 60, "testPattern");
+
+        // Create a simple test palette
+        ColorPalette testPalette;
+        testPalette.colorCount = 3;
+        testPalette.colors[0] = RGBColor{255, 0, 0}; // Red
+        testPalette.colors[1] = RGBColor{0, 255, 0}; // Green
+        testPalette.colors[2] = RGBColor{0, 0, 255}; // Blue
+
+        lightManager->displayPalette(testPalette);
+    }
+
+    pushEvent(event);
+}
+
+void LightingTask::pushEvent(const LightEvent &event)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    if (eventCount >= LIGHTING_EVENT_QUEUE_SIZE)
+    {
+        // Keep the most recent state: drop the oldest event
+        eventHead = (eventHead + 1) % LIGHTING_EVENT_QUEUE_SIZE;
+        eventCount--;
+        Serial.println("⚠ Lighting event queue full - oldest event dropped");
+    }
+
+    events[(eventHead + eventCount) % LIGHTING_EVENT_QUEUE_SIZE] = event;
+    eventCount++;
+
+    xSemaphoreGive(mutex);
+}
+
+void LightingTask::reportProgress(uint32_t commandId, int progress, const char *stage)
+{
+    LightEvent event;
+    event.type = LIGHT_EVENT_PROGRESS;
+    event.commandId = commandId;
+    event.success = true;
+    event.stage = stage;
+    event.progress = progress;
+    pushEvent(event);
+}
+
+void LightingTask::updateSnapshot()
+{
+    String systemType = lightManager->getCurrentSystemType();
+    bool ready = lightManager->hasReadyTarget();
+    bool needsAuth = lightManager->requiresUserAuthentication();
+    int targetCount = lightManager->getTargetCount();
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    snapshotSystemType = systemType;
+    snapshotReady = ready;
+    snapshotNeedsAuth = needsAuth;
+    snapshotTargetCount = targetCount;
+    xSemaphoreGive(mutex);
+}
+
+String LightingTask::buildStatus(bool refresh)
+{
+    JsonDocument status;
+
+    // Get lighting system status - check if system type is configured
+    String systemType = lightManager->getCurrentSystemType();
+    bool hasLightingSystem = (systemType.length() > 0 && systemType != "none");
+
+    if (hasLightingSystem)
+    {
+        status["hasLightingSystem"] = true;
+        status["isReady"] = lightManager->isReady();
+        status["systemType"] = systemType;
+
+        // Controller status and capabilities may need HTTP requests, so they
+        // are only queried after configuration changes or when asked to
+        if (refresh || !statusCached)
+        {
+            cachedStatusMessage = lightManager->getStatus();
+            if (lightManager->isReady() && cachedStatusMessage == "Disconnected")
+            {
+                cachedStatusMessage = "Connected and Ready";
+            }
+
+            JsonDocument capabilities;
+            lightManager->getCapabilities(capabilities.to<JsonObject>());
+            cachedCapabilities = "";
+            serializeJson(capabilities, cachedCapabilities);
+            statusCached = true;
+        }
+
+        status["status"] = cachedStatusMessage;
+        status["capabilities"] = serialized(cachedCapabilities);
+
+        // Per-target readiness and the outcome of the last palette display
+        lightManager->getTargetStatus(status["targets"].to<JsonArray>());
+        const DisplayReport &lastDisplay = lightManager->getLastDisplayReport();
+        if (lastDisplay.targetCount > 0)
+        {
+            status["lastDisplay"]["latencyMs"] = lastDisplay.latencyMs;
+            status["lastDisplay"]["successCount"] = lastDisplay.successCount;
+            status["lastDisplay"]["targetCount"] = lastDisplay.targetCount;
+        }
+    }
+    else
+    {
+        status["hasLightingSystem"] = false;
+        status["isReady"] = false;
+        status["systemType"] = "none";
+        status["status"] = "No lighting system configured";
+    }
+
+    String result;
+    serializeJson(status, result);
+    return result;
+}
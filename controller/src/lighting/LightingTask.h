@@ -0,0 +1,180 @@
+#ifndef LIGHTING_TASK_H
+#define LIGHTING_TASK_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "LightManager.h"
+#include "../core/HttpTransport.h"
+#include "../config.h"
+
+/**
+ * Commands accepted by the lighting task
+ */
+enum LightCommandType
+{
+    LIGHT_CMD_BEGIN,           // Load the stored configuration and initialize controllers
+    LIGHT_CMD_DISPLAY_PALETTE, // Display a palette on all targets
+    LIGHT_CMD_CONFIGURE,       // Configure a target, optionally followed by authentication
+    LIGHT_CMD_AUTHENTICATE,    // Authenticate the primary system
+    LIGHT_CMD_TEST,            // Test the connection and show a test pattern
+    LIGHT_CMD_REPORT_STATUS,   // Build a lightingSystemStatus snapshot
+    LIGHT_CMD_RESET            // Clear the stored lighting configuration
+};
+
+struct LightCommand
+{
+    LightCommandType type;
+    uint32_t id;
+    String reference; // Requesting deviceId for tests (palettes carry their own messageId)
+    ColorPalette palette;
+    String systemType;
+    String hostAddress;
+    int port;
+    String authToken;
+    String customConfig; // Serialized JSON object
+    int targetIndex;
+    bool authenticate;
+    bool refresh; // LIGHT_CMD_REPORT_STATUS: query the controller instead of using the cached status
+
+    LightCommand() : type(LIGHT_CMD_REPORT_STATUS), id(0), port(80), targetIndex(0), authenticate(false), refresh(false) {}
+};
+
+/**
+ * Completion events posted back to the WebSocket client
+ */
+enum LightEventType
+{
+    LIGHT_EVENT_READY,             // LIGHT_CMD_BEGIN finished
+    LIGHT_EVENT_PALETTE_DISPLAYED, // All targets answered a palette display
+    LIGHT_EVENT_CONFIGURED,
+    LIGHT_EVENT_AUTHENTICATED,
+    LIGHT_EVENT_TESTED,
+    LIGHT_EVENT_STATUS,
+    LIGHT_EVENT_USER_ACTION, // A controller needs the user (e.g. Nanoleaf pairing button)
+    LIGHT_EVENT_PROGRESS     // A long command reached a new stage
+};
+
+struct LightEvent
+{
+    LightEventType type;
+    uint32_t commandId;
+    bool success;
+    String reference;
+    DisplayReport report; // LIGHT_EVENT_PALETTE_DISPLAYED
+    String status;        // Serialized lightingSystemStatus data, if the command changed it
+    String action;        // LIGHT_EVENT_USER_ACTION
+    String instructions;
+    int timeout;
+    String stage; // LIGHT_EVENT_PROGRESS
+    int progress; // LIGHT_EVENT_PROGRESS, 0-100
+
+    LightEvent() : type(LIGHT_EVENT_STATUS), commandId(0), success(false), timeout(0), progress(0) {}
+};
+
+/**
+ * Lighting Task
+ *
+ * Runs every LightManager operation on a dedicated FreeRTOS task so that slow
+ * lights (HTTP discovery, pairing, unreachable hosts) never stall WebSocket
+ * servicing. Callers post typed commands into a bounded queue and receive
+ * completion events through pollEvent() on their own task.
+ *
+ * After begin() the LightManager must only be touched from this task.
+ */
+class LightingTask
+{
+public:
+    LightingTask(LightManager *lightManager, HttpTransport *transport);
+
+    /**
+     * Start the task
+     */
+    bool begin();
+
+    /**
+     * Queue a command
+     * @return command id, or 0 if the queue is full
+     */
+    uint32_t post(const LightCommand &command);
+
+    // Convenience wrappers around post()
+    uint32_t displayPalette(const ColorPalette &palette);
+    uint32_t configure(int targetIndex, const String &systemType, const String &hostAddress,
+                       int port, const String &authToken, const String &customConfig, bool authenticate);
+    uint32_t authenticate();
+    uint32_t test(const String &deviceId);
+    uint32_t requestStatus(bool refresh = false);
+    uint32_t reloadConfiguration();
+    uint32_t resetConfiguration();
+
+    /**
+     * Take the next completion event
+     * @return false when no event is pending
+     */
+    bool pollEvent(LightEvent &event);
+
+    // Snapshot of the lighting state, refreshed after every command
+    String getSystemType();
+    bool isReady();
+
+    /**
+     * Whether a palette posted now will reach the lights: a target exists,
+     * or a queued LIGHT_CMD_BEGIN may still load one. Palettes queue behind
+     * BEGIN, so they are not lost while the lights start.
+     */
+    bool acceptsPalettes();
+    bool requiresUserAuthentication();
+    int getTargetCount();
+
+    /**
+     * Number of commands waiting to run
+     */
+    int pendingCommands();
+
+private:
+    LightManager *lightManager;
+    HttpTransport *transport;
+    TaskHandle_t taskHandle;
+    SemaphoreHandle_t mutex;
+    uint32_t nextId;
+    uint32_t currentCommandId; // Command being executed (lighting task only)
+
+    LightCommand commands[LIGHTING_COMMAND_QUEUE_SIZE];
+    int commandHead;
+    int commandCount;
+
+    LightEvent events[LIGHTING_EVENT_QUEUE_SIZE];
+    int eventHead;
+    int eventCount;
+
+    // Snapshot (guarded by mutex)
+    String snapshotSystemType;
+    bool snapshotReady;
+    bool snapshotNeedsAuth;
+    int snapshotTargetCount;
+    int pendingBegins; // LIGHT_CMD_BEGIN queued or running
+
+    // Controller status and capabilities, refreshed after configuration
+    // changes so periodic reports do not hit the network (lighting task only)
+    bool statusCached;
+    String cachedStatusMessage;
+    String cachedCapabilities;
+
+    static void taskEntry(void *param);
+    void run();
+    bool takeCommand(LightCommand &command);
+    bool hasQueuedPalette();
+    void execute(const LightCommand &command);
+    void pushEvent(const LightEvent &event);
+    void reportProgress(uint32_t commandId, int progress, const char *stage);
+    void updateSnapshot();
+    String buildStatus(bool refresh);
+
+    void executeConfigure(const LightCommand &command);
+    void executeTest(const LightCommand &command);
+};
+
+#endif // LIGHTING_TASK_H
@@ -1,12 +1,13 @@
 #include "NanoleafController.h"
 
 NanoleafController::NanoleafController()
-    : panelCount(0), isConnected(false), lastHeartbeat(0), discoveredDeviceCount(0)
+    : panelCount(0), isConnected(false), lastHeartbeat(0), discoveredDeviceCount(0), alive(std::make_shared<bool>(true))
 {
 }
 
 NanoleafController::~NanoleafController()
 {
+    *alive = false;
     if (isConnected)
     {
         disableExternalControl();
@@ -94,7 +95,7 @@ bool NanoleafController::testConnection()
     return false;
 }
 
-bool NanoleafController::displayPalette(const ColorPalette &palette)
+bool NanoleafController::prepareDisplay()
 {
     // If we have an auth token but aren't authenticated, try to validate it first
     if (!isAuthenticated && authToken.length() > 0)
@@ -115,17 +116,8 @@ bool NanoleafController::displayPalette(const ColorPalette &palette)
         return false;
     }
 
-    // If not connected but authenticated, try to reconnect
-    if (!isConnected)
-    {
-        if (!testConnection())
-        {
-            debugLog("❌ Reconnection attempt failed");
-            return false;
-        }
-    }
-
-    debugLog("Displaying palette: " + palette.name + " (" + String(palette.colorCount) + " colors)");
+    // Reachability is tracked by LightManager's circuit breaker, so no
+    // extra connection test is issued before every palette
 
     // Ensure we have panel layout information
     if (panelCount == 0)
@@ -140,37 +132,214 @@ bool NanoleafController::displayPalette(const ColorPalette &palette)
         }
     }
 
+    return true;
+}
+
+String NanoleafController::createDisplayData(const ColorPalette &palette)
+{
     // Check if we have panel information for static color distribution
+    if (panelCount > 0)
+    {
+        return createStaticColorData(palette);
+    }
+
+    // Use the solid color format as fallback when panel info is not available
+    return createSolidColorData(palette);
+}
+
+String NanoleafController::createSolidColorData(const ColorPalette &palette)
+{
+    JsonDocument payload;
+    payload["write"]["command"] = "display";
+    payload["write"]["animType"] = "solid";
+    payload["write"]["colorType"] = "HSB";
+
+    // Create palette array with HSB colors
+    JsonArray paletteArray = payload["write"]["palette"].to<JsonArray>();
+
+    for (int i = 0; i < palette.colorCount; i++)
+    {
+        RGBColor rgbColor = palette.colors[i];
+        HSBColor hsbColor = rgbToHsb(rgbColor);
+
+        JsonObject colorObj = paletteArray.add<JsonObject>();
+        colorObj["hue"] = hsbColor.h;
+        colorObj["saturation"] = hsbColor.s;
+        colorObj["brightness"] = hsbColor.b;
+    }
+
+    String payloadStr;
+    serializeJson(payload, payloadStr);
+    return payloadStr;
+}
+
+bool NanoleafController::displayPalette(const ColorPalette &palette)
+{
+    if (!prepareDisplay())
+    {
+        return false;
+    }
+
+    debugLog("Displaying palette: " + String(palette.name) + " (" + String(palette.colorCount) + " colors)");
+
     if (panelCount > 0)
     {
         return setStaticColors(palette);
     }
-    else
+
+    return sendCommand("/effects", "PUT", createSolidColorData(palette));
+}
+
+void NanoleafController::prepareDisplayAsync(DisplayCallback ready)
+{
+    if (!transport)
     {
-        // Use the solid color format as fallback when panel info is not available
-        JsonDocument payload;
-        payload["write"]["command"] = "display";
-        payload["write"]["animType"] = "solid";
-        payload["write"]["colorType"] = "HSB";
+        ready(false);
+        return;
+    }
 
-        // Create palette array with HSB colors
-        JsonArray paletteArray = payload["write"]["palette"].to<JsonArray>();
+    std::shared_ptr<bool> token = alive;
 
-        for (int i = 0; i < palette.colorCount; i++)
+    // Validate a stored token first, then continue with the layout
+    if (!isAuthenticated && authToken.length() > 0)
+    {
+        HttpRequest request = buildRequest("/", "GET", "");
+        request.callback = [this, token, ready](const HttpResponse &response)
         {
-            RGBColor rgbColor = palette.colors[i];
-            HSBColor hsbColor = rgbToHsb(rgbColor);
+            if (!*token)
+            {
+                ready(false);
+                return;
+            }
 
-            JsonObject colorObj = paletteArray.add<JsonObject>();
-            colorObj["hue"] = hsbColor.h;
-            colorObj["saturation"] = hsbColor.s;
-            colorObj["brightness"] = hsbColor.b;
+            JsonDocument info;
+            if (response.ok() && deserializeJson(info, response.body) == DeserializationError::Ok &&
+                info["name"].is<const char *>())
+            {
+                isAuthenticated = true;
+                isConnected = true;
+                lastHeartbeat = millis();
+                prepareDisplayAsync(ready);
+            }
+            else
+            {
+                debugLog("❌ Auth token validation failed");
+                ready(false);
+            }
+        };
+        if (transport->send(request) == 0)
+        {
+            ready(false);
         }
+        return;
+    }
 
-        String payloadStr;
-        serializeJson(payload, payloadStr);
+    if (!isAuthenticated)
+    {
+        debugLog("Not authenticated to Nanoleaf");
+        ready(false);
+        return;
+    }
 
-        return sendHttpRequest("/effects", "PUT", payloadStr);
+    if (panelCount > 0)
+    {
+        ready(true);
+        return;
+    }
+
+    // Without a layout the palette still goes out in solid color mode
+    HttpRequest request = buildRequest("/panelLayout/layout", "GET", "");
+    request.callback = [this, token, ready](const HttpResponse &response)
+    {
+        if (!*token)
+        {
+            ready(false);
+            return;
+        }
+
+        JsonDocument layout;
+        if (response.ok() && deserializeJson(layout, response.body) == DeserializationError::Ok &&
+            applyPanelLayout(layout))
+        {
+            debugLog("✅ Panel layout retrieved - " + String(panelCount) + " display panels found");
+        }
+        else
+        {
+            debugLog("❌ Failed to get panel layout, falling back to solid color mode");
+        }
+        ready(true);
+    };
+    if (transport->send(request) == 0)
+    {
+        ready(true);
+    }
+}
+
+void NanoleafController::displayPaletteAsync(const ColorPalette &palette, DisplayCallback callback)
+{
+    // Token validation and the panel layout are fetched through the
+    // transport as well, so the caller never waits on the network
+    std::shared_ptr<bool> token = alive;
+    ColorPalette pending = palette;
+    prepareDisplayAsync([this, token, pending, callback](bool ready)
+                        {
+        if (!ready || !*token)
+        {
+            if (callback)
+            {
+                callback(false);
+            }
+            return;
+        }
+
+        debugLog("Displaying palette (async): " + String(pending.name) + " (" + String(pending.colorCount) + " colors)");
+        sendCommandAsync("/effects", "PUT", createDisplayData(pending), callback); });
+}
+
+void NanoleafController::restoreAsync(const LightConfig &config, DisplayCallback callback)
+{
+    this->config = config;
+    authToken = config.authToken;
+    baseUrl = "http://" + config.hostAddress + ":" + String(config.port);
+    isInitialized = true;
+
+    // Let prepareDisplayAsync() validate the token and fetch the layout
+    isAuthenticated = false;
+    panelCount = 0;
+    prepareDisplayAsync([callback](bool ready)
+                        {
+        if (callback)
+        {
+            callback(ready);
+        } });
+}
+
+void NanoleafController::probeAsync(DisplayCallback callback)
+{
+    if (!transport)
+    {
+        if (callback)
+        {
+            callback(false);
+        }
+        return;
+    }
+
+    // Any HTTP answer (even 401 for a stale token) proves the panel is back on the LAN
+    HttpRequest request = buildRequest("/", "GET", "");
+    request.discardBody = true;
+    request.timeoutMs = LIGHT_HEALTH_PROBE_TIMEOUT;
+    request.callback = [callback](const HttpResponse &response)
+    {
+        if (callback)
+        {
+            callback(response.statusCode > 0);
+        }
+    };
+
+    if (transport->send(request) == 0 && callback)
+    {
+        callback(false);
     }
 }
 
@@ -187,7 +356,7 @@ bool NanoleafController::turnOff()
     String payloadStr;
     serializeJson(payload, payloadStr);
 
-    return sendHttpRequest("/state", "PUT", payloadStr);
+    return sendCommand("/state", "PUT", payloadStr);
 }
 
 bool NanoleafController::setBrightness(int brightness)
@@ -206,7 +375,7 @@ bool NanoleafController::setBrightness(int brightness)
     String payloadStr;
     serializeJson(payload, payloadStr);
 
-    bool success = sendHttpRequest("/state", "PUT", payloadStr);
+    bool success = sendCommand("/state", "PUT", payloadStr);
     if (success)
     {
         debugLog("Set brightness to " + String(brightness) + "%");
@@ -302,11 +471,8 @@ bool NanoleafController::isReady() const
            config.authToken.length() > 0;
 }
 
-JsonObject NanoleafController::getCapabilities()
+void NanoleafController::getCapabilities(JsonObject caps)
 {
-    JsonDocument doc;
-    JsonObject caps = doc.to<JsonObject>();
-
     caps["systemType"] = "nanoleaf";
     caps["supportsAnimation"] = true;
     caps["supportsBrightness"] = true;
@@ -320,8 +486,6 @@ JsonObject NanoleafController::getCapabilities()
     supportedAnimations.add("fade");
     supportedAnimations.add("wheel");
     supportedAnimations.add("flow");
-
-    return caps;
 }
 
 bool NanoleafController::discoverNanoleaf()
@@ -441,17 +605,24 @@ bool NanoleafController::requestAuthToken()
 {
     debugLog("Requesting auth token from Nanoleaf");
 
+    if (!transport)
+    {
+        debugLog("❌ No HTTP transport available");
+        return false;
+    }
+
     // Notify user through multiple channels about required action
     notifyUserActionRequired();
 
-    // Build auth URL
-    String authUrl = "http://" + config.hostAddress + ":" + String(config.port) + "/api/v1/new";
-    debugLog("Auth URL: " + authUrl);
-
-    HTTPClient authHttp;
-    authHttp.begin(authUrl);
-    authHttp.addHeader("Content-Type", "application/json");
-    authHttp.setTimeout(5000);
+    // The pairing endpoint lives outside the token-scoped API path
+    HttpRequest authRequest;
+    authRequest.host = config.hostAddress;
+    authRequest.port = config.port;
+    authRequest.method = "POST";
+    authRequest.path = "/api/v1/new";
+    authRequest.body = "{}";
+    authRequest.timeoutMs = 5000;
+    debugLog("Auth URL: http://" + config.hostAddress + ":" + String(config.port) + authRequest.path);
 
     // Try to get auth token for up to 30 seconds
     unsigned long startTime = millis();
@@ -462,15 +633,15 @@ bool NanoleafController::requestAuthToken()
     {
         attempts++;
 
-        int httpResponseCode = authHttp.POST("{}");
+        HttpResponse authResponse = transport->execute(authRequest);
+        int httpResponseCode = authResponse.statusCode;
 
         if (httpResponseCode == 200)
         {
-            String response = authHttp.getString();
-            debugLog("Received auth response: " + response);
+            debugLog("Received auth response: " + authResponse.body);
 
             JsonDocument doc;
-            DeserializationError error = deserializeJson(doc, response);
+            DeserializationError error = deserializeJson(doc, authResponse.body);
 
             if (!error && doc["auth_token"].is<const char *>())
             {
@@ -483,13 +654,12 @@ bool NanoleafController::requestAuthToken()
                 // Notify success
                 notifyUserActionCompleted(true);
 
-                authHttp.end();
                 return true;
             }
             else
             {
                 debugLog("❌ Invalid response format");
-                debugLog("Response: " + response);
+                debugLog("Response: " + authResponse.body);
             }
         }
         else if (httpResponseCode == 403)
@@ -514,7 +684,6 @@ bool NanoleafController::requestAuthToken()
         delay(2000); // Wait 2 seconds before trying again
     }
 
-    authHttp.end();
     debugLog("⏰ Authentication timeout after " + String(attempts) + " attempts");
 
     // Notify timeout/failure
@@ -531,6 +700,11 @@ bool NanoleafController::getPanelLayout()
         return false;
     }
 
+    return applyPanelLayout(response);
+}
+
+bool NanoleafController::applyPanelLayout(JsonDocument &response)
+{
     JsonArray positionData = response["positionData"];
     int totalPanelsFound = positionData.size();
 
@@ -563,7 +737,7 @@ bool NanoleafController::getPanelLayout()
 bool NanoleafController::setStaticColors(const ColorPalette &palette)
 {
     String colorData = createStaticColorData(palette);
-    bool result = sendHttpRequest("/effects", "PUT", colorData);
+    bool result = sendCommand("/effects", "PUT", colorData);
 
     if (result)
     {
@@ -586,7 +760,7 @@ bool NanoleafController::setAnimatedColors(const ColorPalette &palette, const St
         anim = FLOW;
 
     String animationData = createColorAnimationData(palette, anim);
-    return sendHttpRequest("/effects", "PUT", animationData);
+    return sendCommand("/effects", "PUT", animationData);
 }
 
 bool NanoleafController::enableExternalControl()
@@ -599,7 +773,7 @@ bool NanoleafController::enableExternalControl()
     String payloadStr;
     serializeJson(payload, payloadStr);
 
-    return sendHttpRequest("/effects", "PUT", payloadStr);
+    return sendCommand("/effects", "PUT", payloadStr);
 }
 
 bool NanoleafController::disableExternalControl()
@@ -611,107 +785,158 @@ bool NanoleafController::disableExternalControl()
     String payloadStr;
     serializeJson(payload, payloadStr);
 
-    return sendHttpRequest("/effects", "PUT", payloadStr);
+    return sendCommand("/effects", "PUT", payloadStr);
 }
 
-bool NanoleafController::sendHttpRequest(const String &endpoint, const String &method, const String &payload, JsonDocument *response)
+HttpRequest NanoleafController::buildRequest(const String &endpoint, const String &method, const String &payload)
 {
-    // Build URL using working controller pattern: baseUrl + "/api/v1/" + authToken + endpoint
-    String url = baseUrl + "/api/v1";
+    // Token-scoped API path: /api/v1/<authToken><endpoint>
+    HttpRequest request;
+    request.host = config.hostAddress;
+    request.port = config.port;
+    request.method = method;
+    request.path = "/api/v1";
 
     if (authToken.length() > 0)
     {
-        url += "/" + authToken;
+        request.path += "/" + authToken;
     }
 
-    url += endpoint;
-
-    // Only log URL for debugging, not every header detail
-    if (endpoint == "/effects" && method == "PUT")
-    {
-        debugLog("🎨 Sending color data to Nanoleaf");
-    }
+    request.path += endpoint;
+    request.body = payload;
+    request.timeoutMs = LIGHT_HTTP_TIMEOUT;
+    return request;
+}
 
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("User-Agent", "PalPalette-ESP32");
+void NanoleafController::logHttpError(int httpResponseCode, const String &path)
+{
+    debugLog("❌ HTTP Error " + String(httpResponseCode));
 
-    int httpResponseCode;
-    if (method == "GET")
+    // Provide specific error guidance
+    if (httpResponseCode == 400)
     {
-        httpResponseCode = http.GET();
+        debugLog("💡 HTTP 400 Bad Request - Possible issues:");
+        debugLog("   - Invalid JSON format in payload");
+        debugLog("   - Invalid panel IDs in animData");
+        debugLog("   - Incorrect animData format");
+        debugLog("   - Missing required fields");
     }
-    else if (method == "POST")
+    else if (httpResponseCode == 401)
     {
-        httpResponseCode = http.POST(payload);
+        debugLog("💡 HTTP 401 Unauthorized - Auth token may be invalid or expired");
     }
-    else if (method == "PUT")
+    else if (httpResponseCode == 404)
     {
-        httpResponseCode = http.PUT(payload);
+        debugLog("💡 HTTP 404 Not Found - Check endpoint path: " + path);
     }
-    else if (method == "DELETE")
+    else if (httpResponseCode == HTTP_TRANSPORT_ERROR_TIMEOUT)
     {
-        httpResponseCode = http.sendRequest("DELETE", payload);
+        debugLog("💡 Request timed out - Nanoleaf may be offline");
     }
-    else
+}
+
+bool NanoleafController::sendHttpRequest(const String &endpoint, const String &method, const String &payload, JsonDocument *response)
+{
+    if (!transport)
     {
-        debugLog("Unsupported HTTP method: " + method);
-        http.end();
+        debugLog("❌ No HTTP transport available");
         return false;
     }
 
-    if (httpResponseCode < 200 || httpResponseCode >= 300)
+    HttpRequest request = buildRequest(endpoint, method, payload);
+    HttpResponse result = transport->execute(request);
+
+    if (!result.ok())
     {
-        debugLog("❌ HTTP Error " + String(httpResponseCode));
+        logHttpError(result.statusCode, endpoint);
 
-        // Get the error response body for more details
-        String errorResponse = http.getString();
-        if (errorResponse.length() > 0)
+        if (result.body.length() > 0)
         {
-            debugLog("📄 Error response body: " + errorResponse);
+            debugLog("📄 Error response body: " + result.body);
         }
+        return false;
+    }
 
-        // Provide specific error guidance
-        if (httpResponseCode == 400)
-        {
-            debugLog("💡 HTTP 400 Bad Request - Possible issues:");
-            debugLog("   - Invalid JSON format in payload");
-            debugLog("   - Invalid panel IDs in animData");
-            debugLog("   - Incorrect animData format");
-            debugLog("   - Missing required fields");
-        }
-        else if (httpResponseCode == 401)
+    if (response != nullptr && result.body.length() > 0)
+    {
+        DeserializationError error = deserializeJson(*response, result.body);
+        if (error)
         {
-            debugLog("💡 HTTP 401 Unauthorized - Auth token may be invalid or expired");
+            debugLog("JSON parsing error: " + String(error.c_str()));
+            return false;
         }
-        else if (httpResponseCode == 404)
+    }
+
+    return true;
+}
+
+bool NanoleafController::sendCommand(const String &endpoint, const String &method, const String &payload)
+{
+    // Fire-and-forget path for state writes (PUT /effects, PUT /state):
+    // the transport completes on the status line and never buffers the body.
+    if (!transport)
+    {
+        debugLog("❌ No HTTP transport available");
+        return false;
+    }
+
+    if (endpoint == "/effects")
+    {
+        debugLog("🎨 Sending color data to Nanoleaf");
+    }
+
+    HttpRequest request = buildRequest(endpoint, method, payload);
+    request.discardBody = true;
+
+    HttpResponse result = transport->execute(request);
+    if (!result.ok())
+    {
+        logHttpError(result.statusCode, endpoint);
+        return false;
+    }
+
+    return true;
+}
+
+bool NanoleafController::sendCommandAsync(const String &endpoint, const String &method, const String &payload, DisplayCallback callback)
+{
+    if (!transport)
+    {
+        debugLog("❌ No HTTP transport available");
+        if (callback)
         {
-            debugLog("💡 HTTP 404 Not Found - Check endpoint URL: " + url);
+            callback(false);
         }
+        return false;
     }
 
-    if (httpResponseCode > 0)
-    {
-        String responseStr = http.getString();
+    HttpRequest request = buildRequest(endpoint, method, payload);
+    request.discardBody = true;
 
-        if (response != nullptr && responseStr.length() > 0)
+    // The controller may be replaced before the response arrives, so the
+    // completion handler must not touch controller state
+    request.callback = [callback](const HttpResponse &response)
+    {
+        if (!response.ok())
         {
-            DeserializationError error = deserializeJson(*response, responseStr);
-            if (error)
-            {
-                debugLog("JSON parsing error: " + String(error.c_str()));
-                http.end();
-                return false;
-            }
+            Serial.println("[nanoleaf] ❌ Command failed: " + String(response.statusCode));
         }
+        if (callback)
+        {
+            callback(response.ok());
+        }
+    };
 
-        http.end();
-        return (httpResponseCode >= 200 && httpResponseCode < 300);
+    if (transport->send(request) == 0)
+    {
+        if (callback)
+        {
+            callback(false);
+        }
+        return false;
     }
 
-    debugLog("HTTP request failed");
-    http.end();
-    return false;
+    return true;
 }
 
 String NanoleafController::createColorAnimationData(const ColorPalette &palette, AnimationType animation)
@@ -3,10 +3,10 @@
 
 #include "../LightController.h"
 #include <WiFi.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include <ESPmDNS.h>
 #include <algorithm>
+#include <memory>
 
 /**
  * Nanoleaf Aurora/Canvas/Shapes controller implementation
@@ -23,7 +23,6 @@
 class NanoleafController : public LightController
 {
 private:
-    HTTPClient http;
     String baseUrl;
     String authToken;
     int panelCount;
@@ -61,6 +60,10 @@ private:
     DiscoveredDevice discoveredDevices[10]; // Support up to 10 discovered devices
     int discoveredDeviceCount;
 
+    // Cleared by the destructor; completions of chained async requests check
+    // it before touching controller state
+    std::shared_ptr<bool> alive;
+
 public:
     // HSB color structure for Nanoleaf API
     struct HSBColor
@@ -80,6 +83,9 @@ public:
     bool initialize(const LightConfig &config) override;
     bool testConnection() override;
     bool displayPalette(const ColorPalette &palette) override;
+    void displayPaletteAsync(const ColorPalette &palette, DisplayCallback callback) override;
+    void probeAsync(DisplayCallback callback) override;
+    void restoreAsync(const LightConfig &config, DisplayCallback callback) override;
     bool turnOff() override;
     bool setBrightness(int brightness) override;
     String getStatus() override;
@@ -87,7 +93,7 @@ public:
     bool authenticate() override;
     bool requiresAuthentication() override;
     LightConfig getUpdatedConfig() override;
-    JsonObject getCapabilities() override;
+    void getCapabilities(JsonObject caps) override;
     bool isReady() const override;
 
     // Nanoleaf-specific methods
@@ -120,6 +126,15 @@ public:
 
 private:
     bool sendHttpRequest(const String &endpoint, const String &method, const String &payload = "", JsonDocument *response = nullptr);
+    bool sendCommand(const String &endpoint, const String &method, const String &payload); // Status-only, body is discarded
+    bool sendCommandAsync(const String &endpoint, const String &method, const String &payload, DisplayCallback callback);
+    HttpRequest buildRequest(const String &endpoint, const String &method, const String &payload);
+    void logHttpError(int httpResponseCode, const String &path);
+    bool prepareDisplay();
+    void prepareDisplayAsync(DisplayCallback ready); // Same checks as prepareDisplay() without blocking
+    bool applyPanelLayout(JsonDocument &response);
+    String createDisplayData(const ColorPalette &palette);
+    String createSolidColorData(const ColorPalette &palette);
     String createColorAnimationData(const ColorPalette &palette, AnimationType animation);
     String createStaticColorData(const ColorPalette &palette);
     bool validateAuthToken();
@@ -1,13 +1,14 @@
 #include "WLEDController.h"
 
 WLEDController::WLEDController()
-    : ledCount(0), isConnected(false)
+    : ledCount(0), isConnected(false), alive(std::make_shared<bool>(true))
 {
 }
 
 WLEDController::~WLEDController()
 {
-    // WLED doesn't require cleanup
+    // WLED doesn't require cleanup beyond orphaning pending completions
+    *alive = false;
 }
 
 bool WLEDController::initialize(const LightConfig &config)
@@ -17,12 +18,7 @@ bool WLEDController::initialize(const LightConfig &config)
     debugLog("Initializing WLED controller");
     debugLog("Host: " + config.hostAddress + ":" + String(config.port));
 
-    // Build base URL
-    baseUrl = "http://" + config.hostAddress;
-    if (config.port != 80)
-    {
-        baseUrl += ":" + String(config.port);
-    }
+    setBaseUrl();
 
     // Test connection and get info
     if (testConnection())
@@ -62,7 +58,7 @@ bool WLEDController::displayPalette(const ColorPalette &palette)
         return false;
     }
 
-    debugLog("Displaying palette: " + palette.name + " with " + String(palette.colorCount) + " colors");
+    debugLog("Displaying palette: " + String(palette.name) + " with " + String(palette.colorCount) + " colors");
 
     JsonDocument command = createColorCommand(palette);
     bool success = sendWLEDCommand(command);
@@ -79,6 +75,122 @@ bool WLEDController::displayPalette(const ColorPalette &palette)
     return success;
 }
 
+void WLEDController::displayPaletteAsync(const ColorPalette &palette, DisplayCallback callback)
+{
+    if (!isConnected || !transport)
+    {
+        debugLog("Not connected to WLED");
+        if (callback)
+        {
+            callback(false);
+        }
+        return;
+    }
+
+    debugLog("Displaying palette (async): " + String(palette.name) + " with " + String(palette.colorCount) + " colors");
+
+    JsonDocument command = createColorCommand(palette);
+    command["v"] = false;
+
+    String payload;
+    serializeJson(command, payload);
+
+    HttpRequest request = buildRequest("/json/state", "POST", payload);
+    request.discardBody = true;
+
+    // The controller may be replaced before the response arrives, so the
+    // completion handler must not touch controller state
+    request.callback = [callback](const HttpResponse &response)
+    {
+        if (!response.ok())
+        {
+            Serial.println("[wled] ❌ Failed to display color palette: " + String(response.statusCode));
+        }
+        if (callback)
+        {
+            callback(response.ok());
+        }
+    };
+
+    if (transport->send(request) == 0 && callback)
+    {
+        callback(false);
+    }
+}
+
+void WLEDController::restoreAsync(const LightConfig &config, DisplayCallback callback)
+{
+    this->config = config;
+    setBaseUrl();
+
+    if (!transport)
+    {
+        if (callback)
+        {
+            callback(false);
+        }
+        return;
+    }
+
+    debugLog("Restoring WLED controller (async)");
+
+    // Same checks as initialize(), with the info document parsed from one response
+    std::shared_ptr<bool> token = alive;
+    HttpRequest request = buildRequest("/json/info", "GET", "");
+    request.callback = [this, token, callback](const HttpResponse &response)
+    {
+        bool restored = false;
+        JsonDocument info;
+        if (*token && response.ok() && deserializeJson(info, response.body) == DeserializationError::Ok &&
+            info["ver"].is<const char *>())
+        {
+            debugLog("Successfully reconnected to WLED version: " + String(info["ver"].as<const char *>()));
+            isConnected = true;
+            isInitialized = true;
+            isAuthenticated = true;
+            applyInfo(info);
+            restored = true;
+        }
+        if (callback)
+        {
+            callback(restored);
+        }
+    };
+
+    if (transport->send(request) == 0 && callback)
+    {
+        callback(false);
+    }
+}
+
+void WLEDController::probeAsync(DisplayCallback callback)
+{
+    if (!transport)
+    {
+        if (callback)
+        {
+            callback(false);
+        }
+        return;
+    }
+
+    HttpRequest request = buildRequest("/json/info", "GET", "");
+    request.discardBody = true;
+    request.timeoutMs = LIGHT_HEALTH_PROBE_TIMEOUT;
+    request.callback = [callback](const HttpResponse &response)
+    {
+        if (callback)
+        {
+            callback(response.statusCode > 0);
+        }
+    };
+
+    if (transport->send(request) == 0 && callback)
+    {
+        callback(false);
+    }
+}
+
 bool WLEDController::turnOff()
 {
     JsonDocument command;
@@ -150,11 +262,8 @@ bool WLEDController::isReady() const
     return isInitialized && isAuthenticated && config.hostAddress.length() > 0;
 }
 
-JsonObject WLEDController::getCapabilities()
+void WLEDController::getCapabilities(JsonObject caps)
 {
-    JsonDocument doc;
-    JsonObject caps = doc.to<JsonObject>();
-
     caps["systemType"] = "wled";
     caps["supportsAnimation"] = true;
     caps["supportsBrightness"] = true;
@@ -168,8 +277,6 @@ JsonObject WLEDController::getCapabilities()
     supportedAnimations.add("fade");
     supportedAnimations.add("wipe");
     supportedAnimations.add("rainbow");
-
-    return caps;
 }
 
 bool WLEDController::setSegmentColors(const ColorPalette &palette)
@@ -241,22 +348,37 @@ bool WLEDController::getInfo()
         return false;
     }
 
-    if (response["leds"].is<JsonObject>())
+    applyInfo(response);
+    return true;
+}
+
+void WLEDController::applyInfo(const JsonDocument &info)
+{
+    if (info["leds"].is<JsonObjectConst>())
     {
-        JsonObject leds = response["leds"];
-        ledCount = leds["count"];
+        ledCount = info["leds"]["count"];
         debugLog("WLED has " + String(ledCount) + " LEDs configured");
     }
+}
 
-    return true;
+void WLEDController::setBaseUrl()
+{
+    baseUrl = "http://" + config.hostAddress;
+    if (config.port != 80)
+    {
+        baseUrl += ":" + String(config.port);
+    }
 }
 
-bool WLEDController::sendWLEDCommand(const JsonDocument &command)
+bool WLEDController::sendWLEDCommand(JsonDocument &command)
 {
+    // Ask WLED not to echo the full state object back; we only need the status code
+    command["v"] = false;
+
     String payload;
     serializeJson(command, payload);
 
-    return sendHttpRequest("/json/state", "POST", payload);
+    return sendCommand("/json/state", "POST", payload);
 }
 
 JsonDocument WLEDController::createColorCommand(const ColorPalette &palette)
@@ -274,7 +396,7 @@ JsonDocument WLEDController::createColorCommand(const ColorPalette &palette)
     segment["on"] = true;
 
     // Choose effect based on palette animation
-    if (palette.animation == "static")
+    if (palette.hasAnimation("static"))
     {
         segment["fx"] = 0; // Solid color
         // For static, use the first color
@@ -284,7 +406,7 @@ JsonDocument WLEDController::createColorCommand(const ColorPalette &palette)
         primaryColor.add(palette.colors[0].g);
         primaryColor.add(palette.colors[0].b);
     }
-    else if (palette.animation == "fade")
+    else if (palette.hasAnimation("fade"))
     {
         segment["fx"] = 1; // Blink/fade effect
         // Set up to 3 colors for the effect
@@ -329,61 +451,79 @@ JsonDocument WLEDController::createColorCommand(const ColorPalette &palette)
     return command;
 }
 
-bool WLEDController::sendHttpRequest(const String &endpoint, const String &method, const String &payload, JsonDocument *response)
+HttpRequest WLEDController::buildRequest(const String &endpoint, const String &method, const String &payload)
 {
-    String url = baseUrl + endpoint;
+    HttpRequest request;
+    request.host = config.hostAddress;
+    request.port = config.port;
+    request.method = method;
+    request.path = endpoint;
+    request.body = payload;
+    request.timeoutMs = LIGHT_HTTP_TIMEOUT;
+    return request;
+}
 
-    debugLog(method + " " + url);
+bool WLEDController::sendHttpRequest(const String &endpoint, const String &method, const String &payload, JsonDocument *response)
+{
+    debugLog(method + " " + baseUrl + endpoint);
     if (payload.length() > 0)
     {
         debugLog("Payload: " + payload);
     }
 
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-
-    int httpResponseCode;
-    if (method == "GET")
+    if (!transport)
     {
-        httpResponseCode = http.GET();
+        debugLog("No HTTP transport available");
+        return false;
     }
-    else if (method == "POST")
+
+    HttpResponse result = transport->execute(buildRequest(endpoint, method, payload));
+
+    debugLog("HTTP Response Code: " + String(result.statusCode));
+
+    if (result.statusCode <= 0)
     {
-        httpResponseCode = http.POST(payload);
+        debugLog("HTTP request failed");
+        return false;
     }
-    else if (method == "PUT")
+
+    if (response != nullptr && result.body.length() > 0)
     {
-        httpResponseCode = http.PUT(payload);
+        DeserializationError error = deserializeJson(*response, result.body);
+        if (error)
+        {
+            debugLog("JSON parsing error: " + String(error.c_str()));
+            return false;
+        }
     }
-    else
+
+    return result.ok();
+}
+
+bool WLEDController::sendCommand(const String &endpoint, const String &method, const String &payload)
+{
+    // Fire-and-forget path for state writes: the transport completes on the
+    // status line and drops the connection instead of buffering the body.
+    debugLog(method + " " + baseUrl + endpoint + " (status only)");
+
+    if (!transport)
     {
-        debugLog("Unsupported HTTP method: " + method);
-        http.end();
+        debugLog("No HTTP transport available");
         return false;
     }
 
-    debugLog("HTTP Response Code: " + String(httpResponseCode));
+    HttpRequest request = buildRequest(endpoint, method, payload);
+    request.discardBody = true;
 
-    if (httpResponseCode > 0)
-    {
-        String responseStr = http.getString();
+    HttpResponse result = transport->execute(request);
 
-        if (response != nullptr && responseStr.length() > 0)
-        {
-            DeserializationError error = deserializeJson(*response, responseStr);
-            if (error)
-            {
-                debugLog("JSON parsing error: " + String(error.c_str()));
-                http.end();
-                return false;
-            }
-        }
+    debugLog("HTTP Response Code: " + String(result.statusCode));
 
-        http.end();
-        return (httpResponseCode >= 200 && httpResponseCode < 300);
+    if (result.statusCode <= 0)
+    {
+        debugLog("HTTP request failed");
+        return false;
     }
 
-    debugLog("HTTP request failed");
-    http.end();
-    return false;
+    return result.ok();
 }
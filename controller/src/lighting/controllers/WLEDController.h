@@ -3,8 +3,8 @@
 
 #include "../LightController.h"
 #include <WiFi.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include <memory>
 
 /**
  * WLED controller implementation
@@ -22,11 +22,14 @@
 class WLEDController : public LightController
 {
 private:
-    HTTPClient http;
     String baseUrl;
     int ledCount;
     bool isConnected;
 
+    // Cleared by the destructor; the async restore checks it before touching
+    // controller state
+    std::shared_ptr<bool> alive;
+
     // WLED-specific configuration
     struct
     {
@@ -43,13 +46,16 @@ public:
     bool initialize(const LightConfig &config) override;
     bool testConnection() override;
     bool displayPalette(const ColorPalette &palette) override;
+    void displayPaletteAsync(const ColorPalette &palette, DisplayCallback callback) override;
+    void probeAsync(DisplayCallback callback) override;
+    void restoreAsync(const LightConfig &config, DisplayCallback callback) override;
     bool turnOff() override;
     bool setBrightness(int brightness) override;
     String getStatus() override;
     String getSystemType() override;
     bool authenticate() override;
     bool requiresAuthentication() override;
-    JsonObject getCapabilities() override;
+    void getCapabilities(JsonObject caps) override;
     bool isReady() const override;
 
     // WLED-specific methods
@@ -58,9 +64,13 @@ public:
     bool getInfo();
 
 private:
-    bool sendWLEDCommand(const JsonDocument &command);
+    bool sendWLEDCommand(JsonDocument &command);
     JsonDocument createColorCommand(const ColorPalette &palette);
+    void applyInfo(const JsonDocument &info);
+    void setBaseUrl();
     bool sendHttpRequest(const String &endpoint, const String &method, const String &payload = "", JsonDocument *response = nullptr);
+    bool sendCommand(const String &endpoint, const String &method, const String &payload); // Status-only, body is discarded
+    HttpRequest buildRequest(const String &endpoint, const String &method, const String &payload);
 };
 
 #endif // WLED_CONTROLLER_H
@@ -127,23 +127,23 @@ bool WS2812Controller::testConnection()
 
 bool WS2812Controller::displayPalette(const ColorPalette &palette)
 {
-    debugLog("Displaying palette: " + palette.name + " with " + String(palette.colorCount) + " colors");
+    debugLog("Displaying palette: " + String(palette.name) + " with " + String(palette.colorCount) + " colors");
 
     animationState.currentPalette = palette;
 
-    if (palette.animation == "static")
+    if (palette.hasAnimation("static"))
     {
         return startStaticDisplay(palette);
     }
-    else if (palette.animation == "fade")
+    else if (palette.hasAnimation("fade"))
     {
         return startFadeAnimation(palette, palette.duration);
     }
-    else if (palette.animation == "wipe")
+    else if (palette.hasAnimation("wipe"))
     {
         return startWipeAnimation(palette, palette.duration);
     }
-    else if (palette.animation == "rainbow")
+    else if (palette.hasAnimation("rainbow"))
     {
         return startRainbowAnimation(palette.duration);
     }
@@ -229,11 +229,8 @@ bool WS2812Controller::isReady() const
 #endif
 }
 
-JsonObject WS2812Controller::getCapabilities()
+void WS2812Controller::getCapabilities(JsonObject caps)
 {
-    JsonDocument doc;
-    JsonObject caps = doc.to<JsonObject>();
-
     caps["systemType"] = "ws2812";
     caps["supportsAnimation"] = true;
     caps["supportsBrightness"] = true;
@@ -248,8 +245,6 @@ JsonObject WS2812Controller::getCapabilities()
     supportedAnimations.add("fade");
     supportedAnimations.add("wipe");
     supportedAnimations.add("rainbow");
-
-    return caps;
 }
 
 void WS2812Controller::setPixelColor(int pixel, const RGBColor &color)
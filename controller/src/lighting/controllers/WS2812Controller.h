@@ -67,7 +67,7 @@ public:
     String getSystemType() override;
     bool authenticate() override;
     bool requiresAuthentication() override;
-    JsonObject getCapabilities() override;
+    void getCapabilities(JsonObject caps) override;
     bool isReady() const override;
 
     // WS2812-specific methods
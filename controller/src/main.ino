@@ -16,14 +16,22 @@
 #include <Arduino.h>
 #include "config.h"
 #include "core/WiFiManager.h"
+#include "core/BootTimeline.h"
+#include "core/HttpTransport.h"
+#include "core/LoopScheduler.h"
 #include "core/DeviceManager.h"
 #include "core/WSClient.h"
 #include "lighting/LightManager.h"
+#include "lighting/LightingTask.h"
 
 // Global objects
+BootTimeline bootTimeline;
+LoopScheduler scheduler;
+HttpTransport httpTransport;
 WiFiManager wifiManager;
 DeviceManager deviceManager;
 LightManager lightManager;
+LightingTask lightingTask(&lightManager, &httpTransport);
 WSClient *wsClient = nullptr;
 
 // State management
@@ -43,8 +51,6 @@ unsigned long stateChangeTime = 0;
 
 // Timing variables
 unsigned long lastStatusUpdate = 0;
-unsigned long lastWiFiCheck = 0;
-const unsigned long WIFI_CHECK_INTERVAL = 10000; // 10 seconds
 
 // Helper function for repeating strings
 String repeatString(const String &str, int count)
@@ -59,26 +65,50 @@ String repeatString(const String &str, int count)
 
 void setup()
 {
+    unsigned long stepStart = millis();
     Serial.begin(115200);
+
+    // Lights come back before anything else: directly attached strips show
+    // the last palette now, network lights once they are reachable
+    lightManager.setHttpTransport(&httpTransport);
+    bool paletteRestored = lightManager.beginLocal();
+    bootTimeline.step("paletteRestore", stepStart);
+
+    stepStart = millis();
     delay(1000);
+    bootTimeline.step("serialInit", stepStart);
 
     Serial.println("\n" + repeatString("=", 50));
     Serial.println("🎨 PalPalette ESP32 Controller Starting...");
     Serial.println("📦 Firmware Version: " + String(FIRMWARE_VERSION));
     Serial.println("🏗 Architecture: Modular Self-Setup");
     Serial.println(repeatString("=", 50));
+    if (paletteRestored)
+    {
+        Serial.println("⚡ Last palette restored on local lights");
+    }
 
     // Initialize managers
     Serial.println("\n🔧 Initializing system components...");
 
+    stepStart = millis();
     wifiManager.begin();
+    wifiManager.setConnectionListener(onWiFiConnectionChanged);
+    bootTimeline.step("wifiManagerBegin", stepStart);
+
+    stepStart = millis();
+    deviceManager.setHttpTransport(&httpTransport);
     deviceManager.begin();
+    bootTimeline.step("deviceManagerBegin", stepStart);
 
     // Initialize lighting system (WiFi-independent setup only)
     Serial.println("💡 Preparing lighting system...");
 
     // Only load configuration, don't attempt network connections yet
-    if (lightManager.beginWithoutConfig())
+    stepStart = millis();
+    bool lightingReady = lightManager.beginWithoutConfig() && lightingTask.begin();
+    bootTimeline.step("lightingBegin", stepStart);
+    if (lightingReady)
     {
         Serial.println("✅ Lighting system ready - network initialization will occur after WiFi connection");
     }
@@ -103,6 +133,21 @@ void setup()
         Serial.println("📱 Use this code in the mobile app to claim this device");
     }
 
+    // Main loop tasks, run by the scheduler at their own periods
+    // Network servicing is split per subsystem so the loop monitor can tell them apart
+    scheduler.add("http", LOOP_NETWORK_PERIOD, []()
+                  { httpTransport.loop(); });
+    scheduler.add("wifi", LOOP_NETWORK_PERIOD, []()
+                  { wifiManager.loop(); });
+    scheduler.add("websocket", LOOP_NETWORK_PERIOD, []()
+                  {
+        if (wsClient)
+        {
+            wsClient->loop();
+        } });
+    scheduler.add("state", LOOP_STATE_PERIOD, handleStateMachine);
+    scheduler.add("status", LOOP_STATUS_PERIOD, handlePeriodicTasks);
+
     // Start state machine
     setState(STATE_WIFI_SETUP);
 
@@ -112,25 +157,8 @@ void setup()
 
 void loop()
 {
-    // Update all managers
-    wifiManager.loop();
-    lightManager.loop();
-    if (wsClient)
-    {
-        wsClient->loop();
-    }
-
-    // Handle state machine
-    handleStateMachine();
-
-    // Periodic tasks
-    handlePeriodicTasks();
-
-    // Reset watchdog timer to prevent crashes
-    yield();
-
-    // Small delay to prevent watchdog issues and reduce memory pressure
-    delay(100);
+    // Runs whatever is due, then sleeps until the next task is
+    scheduler.runOnce();
 }
 
 void setState(DeviceState newState)
@@ -142,6 +170,14 @@ void setState(DeviceState newState)
 
         String stateName = getStateName(newState);
         Serial.println("🔄 State changed to: " + stateName);
+
+        bootTimeline.phase(stateName.c_str());
+        scheduler.setContext(stateName.c_str());
+        if (newState == STATE_OPERATIONAL || newState == STATE_WAITING_FOR_CLAIM)
+        {
+            // Connected and ready for palettes (or for pairing)
+            bootTimeline.complete();
+        }
     }
 }
 
@@ -234,103 +270,196 @@ void handleWiFiSetup()
 
 void handleWiFiConnecting()
 {
-    static unsigned long connectStartTime = 0;
-
-    if (connectStartTime == 0)
+    // Association and retries run inside WiFiManager; this state waits for
+    // onWiFiConnectionChanged() while the rest of the loop keeps running
+    if (wifiManager.isConnected())
     {
-        connectStartTime = millis();
-        Serial.println("📶 Attempting WiFi connection...");
+        // Link was already up, e.g. when recovering from the error state
+        handleWiFiConnected();
     }
-
-    if (wifiManager.connectToWiFi())
+    else if (wifiManager.getConnectionState() == WIFI_STATE_IDLE)
     {
-        // WiFiManager already prints connection success message
-
-        // Now that WiFi is connected, initialize lighting system with saved configuration
-        Serial.println("🔄 WiFi connected - initializing lighting system with saved configuration...");
-        if (lightManager.begin())
+        Serial.println("📶 Attempting WiFi connection...");
+        if (!wifiManager.beginConnect())
         {
-            Serial.println("✅ Lighting system initialized with saved configuration");
+            setState(STATE_WIFI_SETUP);
         }
-        else
+    }
+}
+
+void handleWiFiConnected()
+{
+    bootTimeline.step(wifiManager.wasLastConnectFast() ? "wifiAssociateFast" : "wifiAssociate", millis(),
+                      wifiManager.getLastConnectMs());
+
+    // Now that WiFi is connected, initialize lighting system with saved configuration
+    // This runs on the lighting task and no longer holds up registration
+    Serial.println("🔄 WiFi connected - initializing lighting system with saved configuration...");
+    lightingTask.reloadConfiguration();
+
+    setState(STATE_DEVICE_REGISTRATION);
+}
+
+void onWiFiConnectionChanged(bool connected)
+{
+    if (connected)
+    {
+        if (currentState == STATE_WIFI_CONNECTING)
         {
-            Serial.println("📝 No saved lighting configuration found - will wait for mobile app setup");
+            handleWiFiConnected();
         }
-
-        connectStartTime = 0;
-        setState(STATE_DEVICE_REGISTRATION);
     }
-    else
+    else if (currentState >= STATE_DEVICE_REGISTRATION)
     {
-        // Check for timeout
-        if (millis() - connectStartTime > WIFI_CONNECT_TIMEOUT)
+        // WiFiManager is already reconnecting. The socket died with the link;
+        // WSClient opens a new one once WiFi is back
+        Serial.println("⚠ WiFi connection lost, waiting for reconnect...");
+        if (wsClient)
         {
-            Serial.println("⏰ WiFi connection timeout, returning to setup mode");
-            connectStartTime = 0;
-            setState(STATE_WIFI_SETUP);
+            wsClient->disconnect();
         }
+        setState(STATE_WIFI_CONNECTING);
     }
 }
 
 void handleDeviceRegistration()
 {
     static bool registrationAttempted = false;
+    static bool awaitingRegistration = false; // HTTP registration and WebSocket handshake in flight
+    static bool awaitingResume = false;       // WSClient is resuming the previous session on its own
+    static unsigned long lastAttempt = 0;
 
     if (!registrationAttempted)
     {
-        Serial.println("📡 Starting device registration process...");
-
-        // First register with HTTP API
         String serverUrl = wifiManager.getServerURL();
-        if (deviceManager.registerWithServer(serverUrl))
-        {
-            Serial.println("✅ Device registered with HTTP API");
 
-            // Initialize WebSocket client
-            if (wsClient)
-            {
-                delete wsClient;
-            }
-            wsClient = new WSClient(&deviceManager, &lightManager);
-            wsClient->begin(serverUrl);
-
-            // Attempt WebSocket connection
-            if (wsClient->connect())
+        if (wsClient && deviceManager.hasSession())
+        {
+            // Back from a WiFi drop: WSClient reconnects on its own backoff and
+            // presents the session token, so neither the HTTP nor the
+            // WebSocket registration is repeated
+            Serial.println("⚡ Resuming previous session, skipping HTTP registration");
+            awaitingResume = true;
+        }
+        else
+        {
+            Serial.println("📡 Starting device registration process...");
+
+            // The HTTP registration, the WebSocket handshake and the lighting
+            // startup (queued on the lighting task) run concurrently; only the
+            // WebSocket registration message waits for the HTTP result.
+            // Lighting readiness is not awaited: palettes that arrive first
+            // queue behind LIGHT_CMD_BEGIN (LightingTask::acceptsPalettes())
+            if (deviceManager.startRegistration(serverUrl))
             {
-                Serial.println("✅ WebSocket connection established");
-
-                // Check provisioning status after registration response
-                if (deviceManager.isProvisioned())
+                if (wsClient)
                 {
-                    Serial.println("🎉 Device is already claimed - transitioning to operational mode");
-                    setState(STATE_OPERATIONAL);
+                    delete wsClient;
                 }
-                else
+                wsClient = new WSClient(&deviceManager, &lightingTask);
+                wsClient->setBootTimeline(&bootTimeline);
+                wsClient->setLoopScheduler(&scheduler);
+                wsClient->begin(serverUrl);
+                wsClient->holdRegistration();
+
+                // Blocks for the handshake while the registration request is on the wire
+                unsigned long connectStart = millis();
+                bool connected = wsClient->connect();
+                bootTimeline.step("wsConnect", connectStart);
+                if (!connected)
                 {
-                    Serial.println("📝 Device is not yet claimed - waiting for user pairing");
-                    setState(STATE_WAITING_FOR_CLAIM);
+                    Serial.println("⚠ WebSocket connection failed, will retry...");
                 }
+                awaitingRegistration = true;
             }
             else
             {
-                Serial.println("⚠ WebSocket connection failed, will retry...");
+                Serial.println("❌ Device registration failed, will retry...");
             }
         }
-        else
+
+        registrationAttempted = true;
+        lastAttempt = millis();
+    }
+
+    if (awaitingResume)
+    {
+        if (wsClient->isRegistrationRejected())
+        {
+            // The backend no longer knows this device: register from scratch
+            awaitingResume = false;
+            registrationAttempted = false;
+        }
+        else if (wsClient->isSessionReady())
+        {
+            // Resumed, or registered again after the backend dropped the session
+            Serial.println("✅ WebSocket session resumed");
+            awaitingResume = false;
+            registrationAttempted = false;
+            enterConnectedState();
+        }
+        return;
+    }
+
+    if (awaitingRegistration)
+    {
+        RegistrationState registration = deviceManager.getRegistrationState();
+        if (registration == REGISTRATION_PENDING)
+        {
+            return;
+        }
+
+        if (registration == REGISTRATION_FAILED)
         {
             Serial.println("❌ Device registration failed, will retry...");
+            awaitingRegistration = false;
+            lastAttempt = millis();
         }
+        else if (wsClient->isClientConnected())
+        {
+            // The WebSocket client reconnects on its own if the first handshake failed
+            if (deviceManager.wasRegistrationSkipped())
+            {
+                bootTimeline.step("httpRegisterSkipped", deviceManager.getRegistrationFinishedAt(), 0);
+            }
+            else
+            {
+                Serial.println("✅ Device registered with HTTP API");
+                bootTimeline.step("httpRegister", deviceManager.getRegistrationFinishedAt(),
+                                  deviceManager.getRegistrationFinishedAt() - deviceManager.getRegistrationStartedAt());
+            }
 
-        registrationAttempted = true;
+            wsClient->releaseRegistration();
+            Serial.println("✅ WebSocket connection established");
+            awaitingRegistration = false;
+            registrationAttempted = false;
+            enterConnectedState();
+        }
+        return;
     }
 
-    // Reset registration attempt flag after delay
-    if (millis() - stateChangeTime > REGISTRATION_RETRY_INTERVAL)
+    // Retry after a delay
+    if (millis() - lastAttempt > REGISTRATION_RETRY_INTERVAL)
     {
         registrationAttempted = false;
     }
 }
 
+void enterConnectedState()
+{
+    // Check provisioning status after registration response
+    if (deviceManager.isProvisioned())
+    {
+        Serial.println("🎉 Device is already claimed - transitioning to operational mode");
+        setState(STATE_OPERATIONAL);
+    }
+    else
+    {
+        Serial.println("📝 Device is not yet claimed - waiting for user pairing");
+        setState(STATE_WAITING_FOR_CLAIM);
+    }
+}
+
 void handleWaitingForClaim()
 {
     // Display pairing information periodically
@@ -395,26 +524,29 @@ void handleError()
 
 void handlePeriodicTasks()
 {
-    // Check WiFi connection periodically
-    if (millis() - lastWiFiCheck > WIFI_CHECK_INTERVAL)
+    // WiFi drops arrive through onWiFiConnectionChanged()
+
+    // A skipped HTTP registration turned out to be stale
+    if (currentState > STATE_DEVICE_REGISTRATION && wsClient && wsClient->isRegistrationRejected())
     {
-        if (currentState >= STATE_DEVICE_REGISTRATION && !wifiManager.isConnected())
-        {
-            Serial.println("⚠ WiFi connection lost, attempting recovery...");
-            setState(STATE_WIFI_CONNECTING);
-        }
-        lastWiFiCheck = millis();
+        Serial.println("🔁 Registering over HTTP again");
+        setState(STATE_DEVICE_REGISTRATION);
     }
 
-    // Update device status periodically (if registered and connected)
+    // Update device status periodically (if registered and connected).
+    // The WebSocket carries it while connected; HTTP is the fallback.
     if (currentState >= STATE_DEVICE_REGISTRATION && deviceManager.shouldUpdateStatus())
     {
-        if (wifiManager.isConnected())
+        if (wsClient && wsClient->sendPeriodicStatus())
+        {
+            deviceManager.markStatusUpdated();
+        }
+        else if (wifiManager.isConnected())
         {
             String serverUrl = wifiManager.getServerURL();
-            if (deviceManager.updateStatus(serverUrl))
+            if (!deviceManager.updateStatus(serverUrl))
             {
-                Serial.println("📊 Device status updated successfully");
+                Serial.println("⚠️ Device status update could not be queued");
             }
         }
     }
@@ -462,6 +594,9 @@ void printSystemStatus()
     Serial.println("⏰ Uptime: " + String(millis() / 1000) + " seconds");
     Serial.println("🔄 Current State: " + getStateName(currentState));
 
+    // Main loop latency
+    scheduler.print();
+
     Serial.println(repeatString("=", 40) + "\n");
 }
 
@@ -497,6 +632,11 @@ void serialEvent()
             Serial.println("  SSID: " + wifiManager.getSSID());
             Serial.println("  IP: " + wifiManager.getLocalIP());
             Serial.println("  Connected: " + String(wifiManager.isConnected() ? "Yes" : "No"));
+            Serial.println("  State: " + String(wifiManager.getConnectionStateName()));
+            Serial.println("  Consecutive failures: " + String(wifiManager.getConsecutiveFailures()));
+            Serial.println("  Last disconnect reason: " + String(wifiManager.getLastDisconnectReason()));
+            Serial.println("  Last association: " + String(wifiManager.getLastConnectMs()) + " ms (" +
+                           (wifiManager.wasLastConnectFast() ? "fast, saved " + String(wifiManager.getFastConnectSavingMs()) + " ms" : "full scan") + ")");
         }
         else if (command == "prefs")
         {
@@ -523,9 +663,10 @@ void serialEvent()
         else if (command == "lights")
         {
             Serial.println("💡 Reinitializing lighting system...");
-            if (lightManager.begin())
+            if (lightingTask.reloadConfiguration())
             {
-                Serial.println("✅ Lighting system reinitialized: " + lightManager.getCurrentSystemType());
+                Serial.println("📥 Reinitialization queued on the lighting task");
+                Serial.println("🎯 Current system: " + lightingTask.getSystemType() + " (" + String(lightingTask.getTargetCount()) + " target(s))");
             }
             else
             {
@@ -535,12 +676,12 @@ void serialEvent()
         else if (command == "nanoleaf")
         {
             Serial.println("🔍 Testing Nanoleaf discovery and connection...");
-            if (lightManager.getCurrentSystemType() == "nanoleaf")
+            if (lightingTask.getSystemType() == "nanoleaf")
             {
                 Serial.println("💡 Current system is Nanoleaf, testing connection...");
-                if (lightManager.testConnection())
+                if (lightingTask.test(""))
                 {
-                    Serial.println("✅ Nanoleaf connection test successful");
+                    Serial.println("📥 Connection test queued - result follows in the log");
                 }
                 else
                 {
@@ -549,10 +690,29 @@ void serialEvent()
             }
             else
             {
-                Serial.println("⚠ Current system is not Nanoleaf (current: " + lightManager.getCurrentSystemType() + ")");
+                Serial.println("⚠ Current system is not Nanoleaf (current: " + lightingTask.getSystemType() + ")");
                 Serial.println("💡 Try 'lights' command to reinitialize lighting system");
             }
         }
+        else if (command == "events")
+        {
+            if (wsClient)
+            {
+                wsClient->printEventStats();
+            }
+            else
+            {
+                Serial.println("⚠ WebSocket client not started");
+            }
+        }
+        else if (command == "boot")
+        {
+            bootTimeline.print();
+        }
+        else if (command == "tasks")
+        {
+            scheduler.print();
+        }
         else if (command == "help")
         {
             Serial.println("🆘 Available Commands:");
@@ -561,6 +721,9 @@ void serialEvent()
             Serial.println("  prefs    - Show preferences debug info");
             Serial.println("  lights   - Reinitialize lighting system");
             Serial.println("  nanoleaf - Test Nanoleaf discovery and connection");
+            Serial.println("  events   - Show WebSocket event statistics");
+            Serial.println("  boot     - Show the boot timeline");
+            Serial.println("  tasks    - Show main loop tasks and latency");
             Serial.println("  reset    - Reset device settings");
             Serial.println("  restart  - Restart the device");
             Serial.println("  help     - Show this help message");